@@ -37,7 +37,6 @@
 #pragma once
 
 #include "pluginterfaces/base/ftypes.h"
-#include <stdlib.h>
 #include <cmath>
 
 namespace Steinberg {
@@ -45,46 +44,86 @@ namespace Vst {
 namespace NoteExpressionSynth {
 
 //-----------------------------------------------------------------------------
-template<class SamplePrecision>
-class BrownNoise
+/** Counter based random generator.
+
+	Every draw is a hash of (key, counter), there is no shared or global state, so each voice
+	owns one and a whole block is a plain loop the compiler can vectorize. The same seed always
+	produces the same sequence.
+*/
+class NoiseRandom
 {
 public:
-	BrownNoise (int32 bufferSize, SamplePrecision sampleRate);
-	~BrownNoise ();
+	NoiseRandom () : key (0x9E3779B9), counter (0) {}
+
+	void seed (uint32 seed)
+	{
+		key = hash (seed ^ 0x9E3779B9) | 1;
+		counter = 0;
+	}
+
+	/** fills out with uniform values in [-1, 1) */
+	template<class T>
+	void fillBipolar (T* out, int32 numSamples)
+	{
+		const uint32 base = counter;
+		for (int32 i = 0; i < numSamples; i++)
+			out[i] = (T)toBipolar (hash (key + (base + (uint32)i) * 0x9E3779B9));
+		counter += (uint32)numSamples;
+	}
+
+	static inline uint32 hash (uint32 x)
+	{
+		x ^= x >> 16;
+		x *= 0x7FEB352D;
+		x ^= x >> 15;
+		x *= 0x846CA68B;
+		x ^= x >> 16;
+		return x;
+	}
+	static inline float toBipolar (uint32 x) { return (float)(x >> 8) * (2.f / 16777216.f) - 1.f; }
 
-	SamplePrecision at (int32 pos) const { return buffer[pos]; }
-	int32 getSize () const { return bufferSize; }
 protected:
-	SamplePrecision* buffer;
-	int32 bufferSize;
+	uint32 key;
+	uint32 counter;
 };
 
 //-----------------------------------------------------------------------------
+/** Per voice brown noise generator, renders a block at a time. */
 template<class SamplePrecision>
-BrownNoise<SamplePrecision>::BrownNoise (int32 bufferSize, SamplePrecision sampleRate)
-: buffer (0)
-, bufferSize (bufferSize)
+class BrownNoise
 {
-	buffer = new SamplePrecision [bufferSize];
+public:
+	BrownNoise () : accu (0), gain (1) {}
 
-	const SamplePrecision f = (SamplePrecision)0.0045;
-	SamplePrecision accu = (SamplePrecision)0.;
-	SamplePrecision y;
-	for (int32 frame = 0; frame < bufferSize; frame++)
+	void setSampleRate (SamplePrecision sampleRate)
 	{
-		y = ((SamplePrecision)rand () / (SamplePrecision)RAND_MAX - (SamplePrecision)0.5) * (SamplePrecision)2.;
-
-		accu = (f * y) + (((SamplePrecision)1.0 - f) * accu);
-		y = (SamplePrecision)1.55 * accu * (SamplePrecision)100. / (SamplePrecision)::sqrt (::sqrt (sampleRate));
-		buffer[frame] = y;
+		gain = (SamplePrecision)1.55 * (SamplePrecision)100. / (SamplePrecision)::sqrt (::sqrt (sampleRate));
+	}
+	void seed (uint32 seed)
+	{
+		random.seed (seed);
+		accu = 0;
 	}
-}
+
+	void process (SamplePrecision* out, int32 numSamples);
+protected:
+	NoiseRandom random;
+	SamplePrecision accu;
+	SamplePrecision gain;
+};
 
 //-----------------------------------------------------------------------------
 template<class SamplePrecision>
-BrownNoise<SamplePrecision>::~BrownNoise ()
+void BrownNoise<SamplePrecision>::process (SamplePrecision* out, int32 numSamples)
 {
-	delete [] buffer;
+	const SamplePrecision f = (SamplePrecision)0.0045;
+
+	random.fillBipolar (out, numSamples);
+	for (int32 frame = 0; frame < numSamples; frame++)
+	{
+		accu = (f * out[frame]) + (((SamplePrecision)1.0 - f) * accu);
+		out[frame] = accu * gain;
+	}
 }
 
 }}} // namespaces
@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/cpugovernor.h
+// Description : Trades render quality for time when the blocks get close to the deadline
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Watches the render time of each block against its duration (the load, 1 = deadline).
+
+	Every block above kOverloadLoad moves one level up, each level keeps the ones below it.
+	Only after kRecoverBlocks blocks in a row below kRecoverLoad it goes one level down again,
+	so the quality does not flip with every block.
+*/
+class CpuGovernor
+{
+public:
+	enum Level
+	{
+		kFullQuality,
+		kCoarseControlRate,		// filter coefficients every kCoarseControlInterval samples
+		kFastOscillators,		// FastMath::sin instead of ::sin
+		kDropReleases,			// quiet releasing voices fade out within kDropReleaseTime
+		kReducedPolyphony,		// new notes fade out the quietest held voice above half the polyphony
+
+		kNumLevels
+	};
+
+	static constexpr double kOverloadLoad = 0.7;
+	static constexpr double kRecoverLoad = 0.4;
+	static constexpr int32 kRecoverBlocks = 100;
+	static constexpr int32 kCoarseControlInterval = 16;	// power of two
+	static constexpr double kDropReleaseLevel = 0.063;	// -24 dB envelope level
+	static constexpr double kDropReleaseTime = 0.005;	// sec
+
+	CpuGovernor () { reset (); }
+
+	void reset ()
+	{
+		level = kFullQuality;
+		calmBlocks = 0;
+	}
+
+	/** load of the block just rendered, returns the level for the next one */
+	Level update (double load)
+	{
+		if (load > kOverloadLoad)
+		{
+			calmBlocks = 0;
+			if (level < kNumLevels - 1)
+				level = (Level)(level + 1);
+		}
+		else if (load < kRecoverLoad && level > kFullQuality)
+		{
+			if (++calmBlocks >= kRecoverBlocks)
+			{
+				calmBlocks = 0;
+				level = (Level)(level - 1);
+			}
+		}
+		else
+			calmBlocks = 0;
+		return level;
+	}
+
+	Level getLevel () const { return level; }
+
+protected:
+	Level level;
+	int32 calmBlocks;
+};
+
+}}} // namespaces
@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/delayline.h
+// Description : Fixed capacity fractional delay line
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include "pluginterfaces/vst/vsttypes.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <new>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Circular delay line with a fixed capacity.
+
+	The buffer is allocated once in setMaxDelay (call it from setActive, never from process).
+	Delay time changes only move the read position: the requested delay is smoothed per sample
+	and read with linear interpolation, so process never touches the heap.
+*/
+template<class SamplePrecision>
+class DelayLine
+{
+public:
+	enum { kAlignment = 64 };
+
+	DelayLine () : memory (nullptr), buffer (nullptr), mask (0), writePos (0),
+	               currentDelay (0.), targetDelay (0.), smoothCoef (1.) {}
+	~DelayLine () { free (memory); }
+
+	inline void setMaxDelay (int32 maxDelaySamples, ParamValue sampleRate);
+	inline void setDelay (ParamValue delaySamples);
+	inline void reset ();
+
+	inline SamplePrecision process (SamplePrecision input);
+
+	int32 getCapacity () const { return mask + 1; }
+protected:
+	DelayLine (const DelayLine&) = delete;
+	DelayLine& operator= (const DelayLine&) = delete;
+
+	void* memory;
+	SamplePrecision* buffer;
+	int32 mask;
+	int32 writePos;
+
+	ParamValue currentDelay;
+	ParamValue targetDelay;
+	ParamValue smoothCoef;
+};
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void DelayLine<SamplePrecision>::setMaxDelay (int32 maxDelaySamples, ParamValue sampleRate)
+{
+	// power of two capacity so wrapping is a mask, +2 for the interpolation neighbour
+	int32 capacity = 1;
+	while (capacity < maxDelaySamples + 2)
+		capacity <<= 1;
+
+	if (capacity != mask + 1)
+	{
+		free (memory);
+		memory = malloc (capacity * sizeof (SamplePrecision) + kAlignment);
+		if (memory == nullptr)
+		{
+			buffer = nullptr;
+			mask = 0;
+			throw std::bad_alloc ();
+		}
+		uintptr_t aligned = ((uintptr_t)memory + kAlignment - 1) & ~(uintptr_t)(kAlignment - 1);
+		buffer = (SamplePrecision*)aligned;
+		mask = capacity - 1;
+	}
+	// 5 ms time constant for delay time changes
+	smoothCoef = 1. - ::exp (-1. / (0.005 * sampleRate));
+	reset ();
+}
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void DelayLine<SamplePrecision>::setDelay (ParamValue delaySamples)
+{
+	if (delaySamples < 0.)
+		delaySamples = 0.;
+	else if (delaySamples > mask - 1)
+		delaySamples = mask - 1;
+	targetDelay = delaySamples;
+}
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void DelayLine<SamplePrecision>::reset ()
+{
+	if (buffer)
+		memset (buffer, 0, (mask + 1) * sizeof (SamplePrecision));
+	writePos = 0;
+	currentDelay = targetDelay;
+}
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+SamplePrecision DelayLine<SamplePrecision>::process (SamplePrecision input)
+{
+	buffer[writePos] = input;
+
+	currentDelay += (targetDelay - currentDelay) * smoothCoef;
+
+	int32 delayInt = (int32)currentDelay;
+	SamplePrecision frac = (SamplePrecision)(currentDelay - delayInt);
+	SamplePrecision a = buffer[(writePos - delayInt) & mask];
+	SamplePrecision b = buffer[(writePos - delayInt - 1) & mask];
+
+	writePos = (writePos + 1) & mask;
+	return a + (b - a) * frac;
+}
+
+}}} // namespaces
@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/fastmath.h
+// Description : Error bounded exp2/log2/pow approximations and a LogScale lookup table
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <cstring>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Replacements for ::pow and friends in per block parameter mapping.
+
+	exp2:  relative error < 2e-7 (0.0004 cent, 2e-6 dB) for x in [-1022, 1023]
+	log2:  absolute error < 2e-9 for x > 0 (normal range)
+	pow:   exp2 (y * log2 (x)), x > 0; x <= 0 yields 0
+	sin:   absolute error < 2e-4 (-74 dB), for the CPU governor's cheap oscillators only
+*/
+namespace FastMath {
+
+static const double kLog2E = 1.4426950408889634074;
+static const double kLog2Of10 = 3.3219280948873623479;
+
+//-----------------------------------------------------------------------------
+inline double exp2 (double x)
+{
+	if (x < -1022.)
+		return 0.;
+	if (x > 1023.)
+		x = 1023.;
+
+	// x = i + f, f in [-0.5, 0.5]: the Taylor remainder of 2^f is below (0.5 ln2)^7 / 7! * sqrt2
+	double fi = (double)(int64)(x + (x >= 0. ? 0.5 : -0.5));
+	double f = (x - fi) * 0.69314718055994530942;
+	double p = 1. + f * (1. + f * (1. / 2. + f * (1. / 6. + f * (1. / 24. + f * (1. / 120. + f * (1. / 720.))))));
+
+	uint64 bits = (uint64)((int64)fi + 1023) << 52;
+	double scale;
+	memcpy (&scale, &bits, sizeof (scale));
+	return p * scale;
+}
+
+//-----------------------------------------------------------------------------
+inline double log2 (double x)
+{
+	uint64 bits;
+	memcpy (&bits, &x, sizeof (bits));
+	int64 e = (int64)((bits >> 52) & 0x7FF) - 1023;
+	bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+	double m;
+	memcpy (&m, &bits, sizeof (m));
+	// m in [sqrt(1/2), sqrt(2)) keeps |s| below 0.172
+	if (m > 1.41421356237309504880)
+	{
+		m *= 0.5;
+		e++;
+	}
+	// ln (m) = 2 atanh (s), s = (m - 1) / (m + 1)
+	double s = (m - 1.) / (m + 1.);
+	double s2 = s * s;
+	double ln = 2. * s * (1. + s2 * (1. / 3. + s2 * (1. / 5. + s2 * (1. / 7. + s2 * (1. / 9.)))));
+	return (double)e + ln * kLog2E;
+}
+
+//-----------------------------------------------------------------------------
+inline double pow (double x, double y)
+{
+	if (x <= 0.)
+		return 0.;
+	return exp2 (y * log2 (x));
+}
+
+//-----------------------------------------------------------------------------
+inline double sinh (double x)
+{
+	double e = exp2 (x * kLog2E);
+	return 0.5 * (e - 1. / e);
+}
+
+//-----------------------------------------------------------------------------
+inline double sin (double x)
+{
+	// reduce to [-pi, pi], then mirror into [-pi/2, pi/2]: the Taylor remainder is below (pi/2)^9 / 9!
+	double k = (double)(int64)(x * 0.15915494309189533577 + (x >= 0. ? 0.5 : -0.5));
+	double r = x - k * 6.28318530717958647693;
+	if (r > 1.57079632679489661923)
+		r = 3.14159265358979323846 - r;
+	else if (r < -1.57079632679489661923)
+		r = -3.14159265358979323846 - r;
+	double r2 = r * r;
+	return r * (1. - r2 * (1. / 6. - r2 * (1. / 120. - r2 * (1. / 5040.))));
+}
+
+} // FastMath
+
+//-----------------------------------------------------------------------------
+/** Precomputed LogScale::scale with linear interpolation.
+
+	update () samples the given scale (only when it changed since the last call), call it
+	before any thread uses scale (), never while one does. With 1024 segments the relative
+	error for the 10 Hz - 20 kHz frequency scale stays below 0.02 cent.
+*/
+template<class T, int32 kSize = 1024>
+class LogScaleTable
+{
+public:
+	LogScaleTable () : inMin (0), inMax (1), inToIndex (kSize) { memset (table, 0, sizeof (table)); }
+
+	template<class Scale>
+	void update (const Scale& logScale, T _inMin = 0, T _inMax = 1)
+	{
+		if (_inMin == inMin && _inMax == inMax && table[0] == logScale.scale (_inMin) &&
+		    table[kSize / 2] == logScale.scale (_inMin + (_inMax - _inMin) / 2) &&
+		    table[kSize] == logScale.scale (_inMax))
+			return;
+		inMin = _inMin;
+		inMax = _inMax;
+		inToIndex = kSize / (inMax - inMin);
+		for (int32 i = 0; i <= kSize; i++)
+			table[i] = logScale.scale (inMin + (inMax - inMin) * i / kSize);
+		table[kSize + 1] = table[kSize];
+	}
+
+	inline T scale (T in) const
+	{
+		T pos = (in - inMin) * inToIndex;
+		if (pos <= 0)
+			return table[0];
+		if (pos >= kSize)
+			return table[kSize];
+		int32 index = (int32)pos;
+		T frac = pos - index;
+		return table[index] + (table[index + 1] - table[index]) * frac;
+	}
+
+protected:
+	T inMin;
+	T inMax;
+	T inToIndex;
+	T table[kSize + 2];
+};
+
+}}} // namespaces
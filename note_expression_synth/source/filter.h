@@ -38,6 +38,8 @@
 
 #include <cmath>
 #include <algorithm>
+#include "denormals.h"
+#include "fastmath.h"
 
 #ifndef M_PI
 #define M_PI       3.14159265358979323846
@@ -125,7 +127,7 @@ void Filter::setFreqAndQ (double freq, double q)
 	if (type == kBandpass)
 	{
 		if (q_is_bandwidth)
-			alpha = tsin * sinh (M_LOG2 * 0.5 * q * omega / tsin);
+			alpha = tsin * FastMath::sinh (M_LOG2 * 0.5 * q * omega / tsin);
 		else
 			alpha = tsin / (2.0 * q);
 
@@ -139,7 +141,7 @@ void Filter::setFreqAndQ (double freq, double q)
 	else
 	{
 		if (q_is_bandwidth)
-			alpha = tsin * sinh (M_LOG2 * 0.5 * q * omega / tsin);
+			alpha = tsin * FastMath::sinh (M_LOG2 * 0.5 * q * omega / tsin);
 		else
 			alpha = tsin / (2.0 * q);
 
@@ -178,6 +180,8 @@ double Filter::process (double sample)
 	in2 = in1;
 	in1 = sample;
 	out2 = out1;
+	// keep the feedback path out of the denormal range while decaying
+	output = flushDenormal (output);
 	out1 = output;
 
 	return output;
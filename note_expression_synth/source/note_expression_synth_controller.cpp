@@ -35,10 +35,17 @@
 //-----------------------------------------------------------------------------
 
 #include "note_expression_synth_controller.h"
-#include "note_expression_synth_voice.h" // only needed for setComponentState
+#include "note_expression_synth_voice.h"
+#include "parameterdescriptors.h"
+#include "presetbank.h"
 #include "base/source/fstring.h"
 #include "pluginterfaces/base/futils.h"
 #include "pluginterfaces/base/ustring.h"
+#include "pluginterfaces/vst/ivstmessage.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
 
 namespace Steinberg {
 namespace Vst {
@@ -237,190 +244,44 @@ tresult PLUGIN_API Controller::initialize (FUnknown* context)
 	if (result == kResultTrue)
 	{
 	// Init parameters
-		Parameter* param;
-		
-		param = new RangeParameter (USTRING("Master Volume"), kParamMasterVolume, USTRING("%"), 0, 100, 80);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Stereo ms"), kParamStereoMs, USTRING("%"), 0, 300, 0);
-        param->setPrecision (2);
-        parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Master Tuning"), kParamMasterTuning, USTRING("cent"), -200, 200, 0);
-		param->setPrecision (0);
-		parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Velocity To Level"), kParamVelToLevel, USTRING("%"), 0, 100, 100);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Release Time"), kParamReleaseTime, USTRING("sec"), 0.005, MAX_RELEASE_TIME_SEC, 0.025);
-		param->setPrecision (3);
-		parameters.addParameter (param);
-
-		param = new RangeParameter(USTRING("AttackTime"), kParamAttackTime, USTRING("sec"), 0.005, MAX_ATTACK_TIME_SEC, 0.025);
-		param->setPrecision(3);
-		parameters.addParameter(param);
-		
-		param = new RangeParameter (USTRING("Noise Volume"), kParamNoiseVolume, USTRING("%"), 0, 100, 0);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Noise Volume Two"), kParamNoiseVolumeTwo, USTRING("%"), 0, 100, 0);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-		param = new RangeParameter (USTRING("Sinus Volume"), kParamSinusVolume, USTRING("%"), 0, 100, 80);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Sinus Volume Two"), kParamSinusVolumeTwo, USTRING("%"), 0, 100, 80);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-		param = new RangeParameter (USTRING("Triangle Volume"), kParamTriangleVolume, USTRING("%"), 0, 100, 20);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Triangle Volume Two"), kParamTriangleVolumeTwo, USTRING("%"), 0, 100, 20);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-		param = new RangeParameter (USTRING("Square Volume"), kParamSquareVolume, USTRING("%"), 0, 100, 80);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Square Volume Two"), kParamSquareVolumeTwo, USTRING("%"), 0, 100, 80);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-		
-		param = new RangeParameter (USTRING("Sinus Detune"), kParamSinusDetune, USTRING("cent"), -200, 200, 0);
-		param->setPrecision (0);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Sinus Detune Two"), kParamSinusDetuneTwo, USTRING("cent"), -200, 200, 0);
-        param->setPrecision (0);
-        parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Triangle Slop"), kParamTriangleSlop, USTRING("%"), 0, 100, 50);
-		param->setPrecision (0);
-		parameters.addParameter (param);
-        param = new RangeParameter (USTRING("Triangle Slop Two"), kParamTriangleSlopTwo, USTRING("%"), 0, 100, 50);
-        param->setPrecision (0);
-        parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Freq Mod On"), kParamFreqModOn, USTRING("%"), 0, 1, 0);
-		param->setPrecision(0);
-		parameters.addParameter(param);
-        param = new RangeParameter (USTRING("Save"), kParamSaveState, USTRING("%"), 0, 1, 0);
-        param->setPrecision(0);
-        parameters.addParameter(param);
-        param = new RangeParameter (USTRING("Load"), kParamLoadState, USTRING("%"), 0, 1, 0);
-        param->setPrecision(0);
-        parameters.addParameter(param);
-
-		param = new Parameter(USTRING("File Path"), kParamFilePath);
-		parameters.addParameter(param);
-		
-        auto* OscTypeParam = new StringListParameter (USTRING("Osc Type"), kParamOscType);
-        OscTypeParam->appendString (USTRING("Sinus"));
-        OscTypeParam->appendString (USTRING("Square"));
-        OscTypeParam->appendString (USTRING("Triangle"));
-        OscTypeParam->appendString (USTRING("Noise"));
-        parameters.addParameter (OscTypeParam);
-        
-        auto* OscTypeParamTwo = new StringListParameter (USTRING("Osc Type Two"), kParamOscTypeTwo);
-        OscTypeParamTwo->appendString (USTRING("Sinus"));
-        OscTypeParamTwo->appendString (USTRING("Square"));
-        OscTypeParamTwo->appendString (USTRING("Triangle"));
-        OscTypeParamTwo->appendString (USTRING("Noise"));
-        parameters.addParameter (OscTypeParamTwo);
-        
-		auto* filterTypeParam = new StringListParameter (USTRING("Filter Type"), kParamFilterType);
-		filterTypeParam->appendString (USTRING("Lowpass"));
-		filterTypeParam->appendString (USTRING("Highpass"));
-		filterTypeParam->appendString (USTRING("Bandpass"));
-		parameters.addParameter (filterTypeParam);
-		
-        param = new LogScaleParameter<ParamValue> (USTRING("Gen Frequency One"), kParamGenFreqOne, VoiceStatics::freqLogScale);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-        VoiceStatics::freqLogScale.changeScaling(0, 1, 10, 20000, .5, 447.213);
-        param = new LogScaleParameter<ParamValue> (USTRING("Gen Frequency Two"), kParamGenFreqTwo, VoiceStatics::freqLogScale);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-		param = new LogScaleParameter<ParamValue> (USTRING("Filter Frequency"), kParamFilterFreq, VoiceStatics::freqLogScale);
-		param->setPrecision (1);
-		param->setNormalized(1);
-		parameters.addParameter (param);
-
-		param = new RangeParameter (USTRING("Frequency Mod Depth"), kParamFilterFreqModDepth, USTRING("%"), -100, 100, 100);
-		param->setPrecision (1);
-		parameters.addParameter (param);
-        
-        
-
-		param = parameters.addParameter (USTRING("Filter Q"), nullptr, 0, 0, ParameterInfo::kCanAutomate, kParamFilterQ);
-		param->setPrecision (2);
-        
-        
-        auto* filterOneTypeParam = new StringListParameter (USTRING("Filter One Type"), kParamFilterOneType);
-        filterOneTypeParam->appendString (USTRING("Lowpass"));
-        filterOneTypeParam->appendString (USTRING("Highpass"));
-        filterOneTypeParam->appendString (USTRING("Bandpass"));
-        parameters.addParameter (filterOneTypeParam);
-        
-        param = new LogScaleParameter<ParamValue> (USTRING("Filter One Frequency"), kParamFilterOneFreq, VoiceStatics::freqLogScale);
-        param->setPrecision (1);
-		param->setNormalized(1);
-        parameters.addParameter (param);
-        
-        param = new RangeParameter (USTRING("Frequency One Mod Depth"), kParamFilterOneFreqModDepth, USTRING("%"), -100, 100, 100);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-        param = parameters.addParameter (USTRING("Filter One Q"), nullptr, 0, 0, ParameterInfo::kCanAutomate, kParamFilterOneQ);
-        param->setPrecision (2);
-        
-        auto* filterTwoTypeParam = new StringListParameter (USTRING("Filter Two Type"), kParamFilterTwoType);
-        filterTwoTypeParam->appendString (USTRING("Lowpass"));
-        filterTwoTypeParam->appendString (USTRING("Highpass"));
-        filterTwoTypeParam->appendString (USTRING("Bandpass"));
-        parameters.addParameter (filterTwoTypeParam);
-        
-        param = new LogScaleParameter<ParamValue> (USTRING("Filter Two Frequency"), kParamFilterTwoFreq, VoiceStatics::freqLogScale);
-		param->setNormalized(1);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-        param = new RangeParameter (USTRING("Frequency Two Mod Depth"), kParamFilterTwoFreqModDepth, USTRING("%"), -100, 100, 100);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-        param = parameters.addParameter (USTRING("Filter Two Q"), nullptr, 0, 0, ParameterInfo::kCanAutomate, kParamFilterTwoQ);
-        param->setPrecision (2);
-        
-        
-        
-
-        
-		parameters.addParameter (USTRING("Bypass SNA"), nullptr, 1, 0, ParameterInfo::kCanAutomate, kParamBypassSNA);
-
-		parameters.addParameter (new RangeParameter (USTRING("Active Voices"), kParamActiveVoices, nullptr, 0, MAX_VOICES, 0, MAX_VOICES, ParameterInfo::kIsReadOnly));
-
-        //param = new RangeParameter(USTRING("SustainTime"), kparamSustainTime, USTRING("sec"), 0.005, MAX_ATTACK_TIME_SEC, 0.025);
-        //param->setPrecision(3);
-        //parameters.addParameter(param);
-        
-        param = new RangeParameter (USTRING("Sustain Volume"), kParamSustainVolume, USTRING("%"), 0, 100, 80);
-        param->setPrecision (1);
-        parameters.addParameter (param);
-        
-        param = new RangeParameter(USTRING("DecayTime"), kParamDecayTime, USTRING("sec"), 0.005, MAX_ATTACK_TIME_SEC, 0.025);
-        param->setPrecision(3);
-        parameters.addParameter(param);
-        
-        
-        
-        
-		auto* tuningRangeParam = new StringListParameter (USTRING("Tuning Range"), kParamTuningRange, nullptr, ParameterInfo::kIsList);
-		tuningRangeParam->appendString (USTRING("[-1, +1] Octave"));
-		tuningRangeParam->appendString (USTRING("[-3, +2] Tunes"));
-		parameters.addParameter (tuningRangeParam);
+		for (const auto& desc : kParameterDescriptors)
+		{
+			Parameter* param = nullptr;
+			switch (desc.kind)
+			{
+				case ParameterDescriptor::kRange:
+				{
+					int32 stepCount = desc.numSteps > 1 ? desc.numSteps - 1 : 0;
+					param = new RangeParameter (USTRING (desc.title), desc.id,
+					                            desc.units ? (const TChar*)USTRING (desc.units) : nullptr,
+					                            desc.minPlain, desc.maxPlain, desc.defaultValue,
+					                            stepCount, desc.flags);
+					break;
+				}
+				case ParameterDescriptor::kLogFrequency:
+				{
+					param = new LogScaleParameter<ParamValue> (USTRING (desc.title), desc.id, VoiceStatics::freqLogScale);
+					param->setNormalized (desc.defaultValue);
+					break;
+				}
+				case ParameterDescriptor::kStringList:
+				{
+					auto* listParam = new StringListParameter (USTRING (desc.title), desc.id, nullptr, desc.flags);
+					for (const char* const* string = desc.strings; *string; string++)
+						listParam->appendString (USTRING (*string));
+					parameters.addParameter (listParam);
+					continue;
+				}
+				case ParameterDescriptor::kPlain:
+				{
+					int32 stepCount = desc.numSteps > 1 ? desc.numSteps - 1 : 0;
+					param = new Parameter (USTRING (desc.title), desc.id, nullptr, desc.defaultValue, stepCount, desc.flags);
+					break;
+				}
+			}
+			param->setPrecision (desc.precision);
+			parameters.addParameter (param);
+		}
 	// Init Note Expression Types
 		auto volumeNoteExp = new NoteExpressionType (kVolumeTypeID, String ("Volume"), String ("Vol"), nullptr, -1, 1., 0., 1., 0, 0);
 		volumeNoteExp->setPhysicalUITypeID(PhysicalUITypeIDs::kPUIPressure);
@@ -529,69 +390,11 @@ tresult PLUGIN_API Controller::setComponentState (IBStream* state)
 	tresult result = gps.setState (state);
 	if (result == kResultTrue)
 	{
-		setParamNormalized (kParamMasterVolume, gps.masterVolume);
-		setParamNormalized (kParamMasterTuning, (gps.masterTuning + 1) / 2.);
-		setParamNormalized (kParamVelToLevel, gps.velToLevel);
-		setParamNormalized (kParamFilterFreqModDepth, (gps.freqModDepth + 1) / 2.);
-
-		setParamNormalized (kParamReleaseTime, gps.releaseTime);
-		setParamNormalized(kParamAttackTime, gps.attackTime);
-        
-        setParamNormalized (kParamSustainVolume, gps.sustainVolume);
-        setParamNormalized(kParamDecayTime, gps.decayTime);
-        
-        
-		setParamNormalized (kParamNoiseVolume, gps.noiseVolume);
-		setParamNormalized (kParamSinusVolume, gps.sinusVolume);
-		setParamNormalized (kParamTriangleVolume, gps.triangleVolume);
-		setParamNormalized (kParamSquareVolume, gps.squareVolume);
-
-		setParamNormalized (kParamSinusDetune, (gps.sinusDetune + 1) / 2.);
-		setParamNormalized (kParamTriangleSlop, gps.triangleSlop);
-        
-        setParamNormalized (kParamNoiseVolumeTwo, gps.noiseVolumeTwo);
-        setParamNormalized (kParamSinusVolumeTwo, gps.sinusVolumeTwo);
-        setParamNormalized (kParamTriangleVolumeTwo, gps.triangleVolumeTwo);
-        setParamNormalized (kParamSquareVolumeTwo, gps.squareVolumeTwo);
-        
-        setParamNormalized (kParamSinusDetuneTwo, (gps.sinusDetuneTwo + 1) / 2.);
-        setParamNormalized (kParamTriangleSlopTwo, gps.triangleSlopTwo);
-        
-
-        setParamNormalized (kParamGenFreqOne,
-                            plainParamToNormalized (kParamGenFreqOne, gps.genFreqOne));
-        setParamNormalized (kParamGenFreqTwo,
-                            plainParamToNormalized (kParamGenFreqTwo, gps.genFreqTwo));
-        setParamNormalized (kParamStereoMs, gps.stereoMs);
-        
-		setParamNormalized (kParamFilterType,
-		                    plainParamToNormalized (kParamFilterType, gps.filterType));
-        setParamNormalized (kParamOscType,
-                            plainParamToNormalized (kParamOscType, gps.oscType));
-        setParamNormalized (kParamOscTypeTwo,
-                            plainParamToNormalized (kParamOscTypeTwo, gps.oscTypeTwo));
-		setParamNormalized (kParamFilterFreq, gps.filterFreq);
-		setParamNormalized (kParamFilterQ, gps.filterQ);
-        
-        setParamNormalized (kParamFilterOneType,
-                            plainParamToNormalized (kParamFilterOneType, gps.filterOneType));
-        setParamNormalized (kParamFilterOneFreq, gps.filterOneFreq);
-        setParamNormalized (kParamFilterOneQ, gps.filterOneQ);
-        
-        setParamNormalized (kParamFilterTwoType,
-                            plainParamToNormalized (kParamFilterTwoType, gps.filterTwoType));
-        setParamNormalized (kParamFilterTwoFreq, gps.filterTwoFreq);
-        setParamNormalized (kParamFilterTwoQ, gps.filterTwoQ);
-
-		setParamNormalized(kParamFreqModOn, gps.freqModOn);
-        setParamNormalized(kParamSaveState, gps.saveState);
-        setParamNormalized(kParamLoadState, gps.loadState);
-		setParamNormalized(kParamFilePath, gps.filePath);
-
-		setParamNormalized (kParamBypassSNA, gps.bypassSNA);
-
-		setParamNormalized (kParamTuningRange,
-		                    plainParamToNormalized (kParamTuningRange, gps.tuningRange));
+		for (const auto& desc : kParameterDescriptors)
+		{
+			if (desc.stateVersion != ParameterDescriptor::kNotStored)
+				setParamNormalized (desc.id, desc.getNormalized (gps));
+		}
 	}
 	return result;
 }
@@ -635,6 +438,48 @@ tresult PLUGIN_API Controller::setParamNormalized (ParamID tag, ParamValue value
 	return res;
 }
 
+//-----------------------------------------------------------------------------
+static bool readFile (const char* path, std::string& contents)
+{
+	std::ifstream file (path, std::ios::binary);
+	if (!file)
+		return false;
+	contents.assign (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+tresult Controller::loadTuning (const char* scalePath, const char* keyboardMappingPath)
+{
+	// the files are read here, the processor only parses what it receives
+	std::string scale;
+	std::string keyboardMapping;
+	if (!readFile (scalePath, scale))
+		return kInvalidArgument;
+	if (keyboardMappingPath && !readFile (keyboardMappingPath, keyboardMapping))
+		return kInvalidArgument;
+
+	IPtr<IMessage> message = owned (allocateMessage ());
+	if (!message)
+		return kResultFalse;
+	message->setMessageID (kTuningMessageID);
+	message->getAttributes ()->setBinary (kTuningScaleAttr, scale.data (), (uint32)scale.size ());
+	if (!keyboardMapping.empty ())
+		message->getAttributes ()->setBinary (kTuningKeyboardMappingAttr, keyboardMapping.data (), (uint32)keyboardMapping.size ());
+	return sendMessage (message);
+}
+
+//-----------------------------------------------------------------------------
+tresult Controller::loadPresetBank (const char* path)
+{
+	IPtr<IMessage> message = owned (allocateMessage ());
+	if (!message)
+		return kResultFalse;
+	message->setMessageID (kPresetBankMessageID);
+	message->getAttributes ()->setBinary (kPresetBankPathAttr, path, (uint32)strlen (path));
+	return sendMessage (message);
+}
+
 //-----------------------------------------------------------------------------
 tresult PLUGIN_API Controller::getMidiControllerAssignment (int32 busIndex, int16 channel,
                                                             CtrlNumber midiControllerNumber,
@@ -45,11 +45,17 @@
 #include <array>
 #include <limits>
 
-#define MAX_VOICES				64
+#define DEFAULT_POLYPHONY		64
+#define MAX_POLYPHONY			256
+#define MAX_RENDER_THREADS		32
+#define MAX_BANK_PRESETS		16384
 #define MAX_RELEASE_TIME_SEC	5.0
 #define MAX_ATTACK_TIME_SEC		5.0
 #define MAX_SUSTAIN_VOLUME_SEC    5.0
 #define MAX_DECAY_TIME_SEC      5.0
+#define MAX_STEREO_DELAY_SEC    0.3
+#define MIN_AUDIBILITY_THRESHOLD_DB	-140.0
+#define MAX_AUDIBILITY_THRESHOLD_DB	-40.0
 #define NUM_FILTER_TYPE			3
 #define NUM_OSC_TYPE            4
 #define NUM_OSC_TYPE_TWO        4
@@ -113,6 +119,15 @@ enum
     kParamLoadState,
     kParamStereoMs,
 	kParamFilePath,
+	kParamRenderThreads,
+	kParamCpuGovernor,
+	kParamAudibilityThreshold,
+	kParamPolyphony,
+	kParamHighPrecision,
+	kParamBankPreset,
+	kParamMorph,
+	kParamMorphStoreA,
+	kParamMorphStoreB,
 
     
 	kNumGlobalParameters
@@ -138,6 +153,11 @@ public:
 	tresult PLUGIN_API setComponentState (IBStream* state) SMTG_OVERRIDE;
 	tresult PLUGIN_API setParamNormalized (ParamID tag, ParamValue value) SMTG_OVERRIDE;
 
+	/** sends a Scala scale and an optional keyboard mapping (nullptr) to the processor */
+	tresult loadTuning (const char* scalePath, const char* keyboardMappingPath);
+	/** makes the processor map a PresetBank file, kParamBankPreset selects its presets */
+	tresult loadPresetBank (const char* path);
+
 	//--- IMidiMapping -------------------------------
 	tresult PLUGIN_API getMidiControllerAssignment (int32 busIndex, int16 channel, CtrlNumber midiControllerNumber, ParamID& id/*out*/) SMTG_OVERRIDE;
 
@@ -35,24 +35,46 @@
 //-----------------------------------------------------------------------------
 
 #include "note_expression_synth_processor.h"
-#include "../../common/voiceprocessor.h"
+#include "note_expression_synth_voiceprocessor.h"
 #include "note_expression_synth_controller.h"
 #include "pluginterfaces/base/ustring.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "note_expression_synth_voice.h"
+#include "denormals.h"
+#include "parameterautomation.h"
+#include "parameterdescriptors.h"
 #include <algorithm>
-#include <iostream>
-#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <string>
 
 namespace Steinberg {
 namespace Vst {
 namespace NoteExpressionSynth {
 
+static_assert ((int32)kNumGlobalParameters <= (int32)ParameterAutomation::kMaxParameters, "parameter ids out of automation range");
+static_assert (MAX_RENDER_THREADS <= RenderPool::kMaxThreads, "kParamRenderThreads exceeds the render pool");
+
+// written and read by kParamSaveState and kParamLoadState
+static const char* kPresetFilePath = "D:/Documents/values.txt";
+
 //-----------------------------------------------------------------------------
 FUID Processor::cid (0x6EE65CD1, 0xB83A4AF4, 0x80AA7929, 0xAEA6B8A0);
 
 //-----------------------------------------------------------------------------
-Processor::Processor () : voiceProcessor (nullptr)
+Processor::Processor ()
+: voiceProcessor (nullptr)
+, outputParameterChanges (nullptr)
+, reportedRenderQuality (-1)
+, presetBank (nullptr)
+, appliedBankPreset (-1)
+, unreportedMorph (0)
+, morphMoving (false)
+, telemetryRuns (0)
+, telemetryKey (0)
+, stereoDelayTail (0)
 {
 	setControllerClass (Controller::cid);
 
@@ -100,8 +122,15 @@ Processor::Processor () : voiceProcessor (nullptr)
     paramState.saveState = 0.0;
     paramState.loadState = 0.0;
 	paramState.filePath = 0.0;
-    
-    
+	paramState.polyphony = (ParamValue)(DEFAULT_POLYPHONY - 1) / (MAX_POLYPHONY - 1);
+	paramState.audibilityThreshold = (-96. - MIN_AUDIBILITY_THRESHOLD_DB) / (MAX_AUDIBILITY_THRESHOLD_DB - MIN_AUDIBILITY_THRESHOLD_DB);
+
+	presetWorker.setPath (kPresetFilePath);
+	presetMorph.store (PresetMorph::kSlotA, paramState);
+	presetMorph.store (PresetMorph::kSlotB, paramState);
+	telemetry = owned (new TelemetryChannel);
+
+	paramSnapshots.publish (paramState);
 }
 
 //-----------------------------------------------------------------------------
@@ -119,13 +148,34 @@ tresult PLUGIN_API Processor::initialize (FUnknown* context)
 //-----------------------------------------------------------------------------
 tresult PLUGIN_API Processor::setState (IBStream* state)
 {
-	return paramState.setState (state);
+	// the next automation ramps start from the loaded values
+	automation.reset ();
+	tresult result = paramState.setState (state);
+	if (result != kResultTrue)
+		return result;
+
+	// the morph slots follow the parameters, states without them morph to themselves
+	for (int32 slot = 0; slot < PresetMorph::kNumSlots; slot++)
+	{
+		GlobalParameterState& slotState = presetMorph.getSlot ((PresetMorph::Slot)slot);
+		slotState = paramState;
+		if (slotState.setState (state) != kResultTrue)
+			slotState = paramState;
+	}
+	return kResultTrue;
 }
 
 //-----------------------------------------------------------------------------
 tresult PLUGIN_API Processor::getState (IBStream* state)
 {
-	return paramState.getState (state);
+	if (paramState.getState (state) != kResultTrue)
+		return kResultFalse;
+	for (int32 slot = 0; slot < PresetMorph::kNumSlots; slot++)
+	{
+		if (presetMorph.getSlot ((PresetMorph::Slot)slot).getState (state) != kResultTrue)
+			return kResultFalse;
+	}
+	return kResultTrue;
 }
 
 //-----------------------------------------------------------------------------
@@ -155,51 +205,85 @@ tresult PLUGIN_API Processor::setActive (TBool state)
 {
 	if (state)
 	{
-		if (paramState.noiseBuffer == nullptr)
-			paramState.noiseBuffer = new BrownNoise<float> ((int32)processSetup.sampleRate,
-			                                                (float)processSetup.sampleRate);
-        if (paramState.noiseBufferTwo == nullptr)
-            paramState.noiseBufferTwo = new BrownNoise<float> ((int32)processSetup.sampleRate,
-                                                            (float)processSetup.sampleRate);
-		if (voiceProcessor == nullptr)
+		int32 maxStereoDelay = (int32)(processSetup.sampleRate * MAX_STEREO_DELAY_SEC) + 1;
+		try
 		{
 			if (processSetup.symbolicSampleSize == kSample32)
-			{
-				voiceProcessor =
-				    new VoiceProcessorImplementation<float, Voice<float>, 2, MAX_VOICES,
-				                                     GlobalParameterState> (
-				        (float)processSetup.sampleRate, &paramState);
-			}
+				stereoDelay32.setMaxDelay (maxStereoDelay, processSetup.sampleRate);
 			else if (processSetup.symbolicSampleSize == kSample64)
+				stereoDelay64.setMaxDelay (maxStereoDelay, processSetup.sampleRate);
+		}
+		catch (const std::bad_alloc&)
+		{
+			// nothing may leave through PLUGIN_API, the processor stays inactive
+			return kOutOfMemory;
+		}
+		stereoDelayTail = 0;
+		automation.reset ();
+
+		if (voiceProcessor == nullptr)
+		{
+			// the voices render in float unless the 64 bit engine is chosen, whatever the host
+			// sample size is
+			float sampleRate = (float)processSetup.sampleRate;
+			int32 numVoices = paramState.getNumVoices ();
+			try
 			{
-				voiceProcessor =
-				    new VoiceProcessorImplementation<double, Voice<double>, 2, MAX_VOICES,
-				                                     GlobalParameterState> (
-				        (float)processSetup.sampleRate, &paramState);
+				if (processSetup.symbolicSampleSize == kSample32)
+				{
+					if (paramState.highPrecision)
+						voiceProcessor = new SynthVoiceProcessorImplementation<float, Voice<double>, 2, GlobalParameterState> (
+						    sampleRate, numVoices, &paramSnapshots);
+					else
+						voiceProcessor = new SynthVoiceProcessorImplementation<float, Voice<float>, 2, GlobalParameterState> (
+						    sampleRate, numVoices, &paramSnapshots);
+				}
+				else if (processSetup.symbolicSampleSize == kSample64)
+				{
+					if (paramState.highPrecision)
+						voiceProcessor = new SynthVoiceProcessorImplementation<double, Voice<double>, 2, GlobalParameterState> (
+						    sampleRate, numVoices, &paramSnapshots);
+					else
+						voiceProcessor = new SynthVoiceProcessorImplementation<double, Voice<float>, 2, GlobalParameterState> (
+						    sampleRate, numVoices, &paramSnapshots);
+				}
+				else
+				{
+					return kInvalidArgument;
+				}
 			}
-			else
+			catch (const std::bad_alloc&)
 			{
-				return kInvalidArgument;
+				// the voice arena or the render lists, new has already released the partly built
+				// processor and voiceProcessor stays nullptr until the next setActive
+				voiceProcessor = nullptr;
+				return kOutOfMemory;
 			}
 		}
+
+		// the sample rate may have changed
+		tuningTables.publish (tuning.createTable (processSetup.sampleRate));
+
+		cpuGovernor.reset ();
+		paramState.renderQuality = CpuGovernor::kFullQuality;
+		reportedRenderQuality = -1;
+
+		// the threads are created here, never while processing
+		renderPool.start (paramState.renderThreads, processSetup.maxSamplesPerBlock / processSetup.sampleRate);
+		voiceProcessor->setRenderPool (&renderPool);
+		presetWorker.start ();
 	}
 	else
 	{
+		renderPool.stop ();
+		presetWorker.stop ();
+		tuningTables.release ();
+		presetBanks.release ();
 		if (voiceProcessor)
 		{
 			delete voiceProcessor;
 		}
 		voiceProcessor = nullptr;
-		if (paramState.noiseBuffer)
-		{
-			delete paramState.noiseBuffer;
-		}
-		paramState.noiseBuffer = nullptr;
-        if (paramState.noiseBufferTwo)
-        {
-            delete paramState.noiseBufferTwo;
-        }
-        paramState.noiseBufferTwo = nullptr;
 	}
 	return AudioEffect::setActive (state);
 }
@@ -207,272 +291,58 @@ tresult PLUGIN_API Processor::setActive (TBool state)
 //-----------------------------------------------------------------------------
 tresult PLUGIN_API Processor::process (ProcessData& data)
 {
-	// TODO: maybe try to make this nearly sample accurate
-	if (data.inputParameterChanges)
+	// no denormals anywhere in the render path, restored when we return to the host
+	ScopedFlushDenormals flushDenormals;
+	auto renderStart = std::chrono::steady_clock::now ();
+
+	// every point of the parameter queues is applied while the voices render
+	outputParameterChanges = data.outputParameterChanges;
+	morphMoving = false;
+	const PresetBank* bank = presetBanks.acquire ();
+	// a new bank is applied at the next point of kParamBankPreset, even at the same index
+	if (bank != presetBank)
+		appliedBankPreset = -1;
+	presetBank = bank;
+	applyLoadedPreset ();
+	automation.begin (data.inputParameterChanges, this);
+	const TuningTable* tuningTable = tuningTables.acquire ();
+	if (tuningTable != paramState.tuning)
 	{
-		int32 count = data.inputParameterChanges->getParameterCount ();
-		for (int32 i = 0; i < count; i++)
-		{
-			IParamValueQueue* queue = data.inputParameterChanges->getParameterData (i);
-			if (queue)
-			{
-				int32 sampleOffset;
-				ParamValue value;
-				ParamID pid = queue->getParameterId ();
-				if (queue->getPoint (queue->getPointCount () - 1, sampleOffset, value) ==
-				    kResultTrue)
-				{
-					switch (pid)
-					{
-						case kParamMasterVolume:
-						{
-							paramState.masterVolume = value;
-							break;
-						}
-						case kParamMasterTuning:
-						{
-							paramState.masterTuning = 2 * (value - 0.5);
-							break;
-						}
-						case kParamVelToLevel:
-						{
-							paramState.velToLevel = value;
-							break;
-						}
-						case kParamFilterFreqModDepth:
-						{
-							paramState.freqModDepth = 2 * (value - 0.5);
-							break;
-						}
-                        case kParamFilterOneFreqModDepth:
-                        {
-                            paramState.freqOneModDepth = 2 * (value - 0.5);
-                            break;
-                        }
-                        case kParamFilterTwoFreqModDepth:
-                        {
-                            paramState.freqTwoModDepth = 2 * (value - 0.5);
-                            break;
-                        }
-
-						case kParamNoiseVolume:
-						{
-							paramState.noiseVolume = value;
-							break;
-						}
-                        case kParamNoiseVolumeTwo:
-                        {
-                            paramState.noiseVolumeTwo = value;
-                            break;
-                        }
-						case kParamSinusVolume:
-						{
-							paramState.sinusVolume = value;
-							break;
-						}
-                        case kParamSinusVolumeTwo:
-                        {
-                            paramState.sinusVolumeTwo = value;
-                            break;
-                        }
-						case kParamTriangleVolume:
-						{
-							paramState.triangleVolume = value;
-							break;
-						}
-                        case kParamTriangleVolumeTwo:
-                        {
-                            paramState.triangleVolumeTwo = value;
-                            break;
-                        }
-						case kParamSquareVolume:
-						{
-							paramState.squareVolume = value;
-							break;
-						}
-                        case kParamSquareVolumeTwo:
-                        {
-                            paramState.squareVolumeTwo = value;
-                            break;
-                        }
-						case kParamReleaseTime:
-						{
-							paramState.releaseTime = value;
-							break;
-						}
-						case kParamAttackTime:
-						{
-							paramState.attackTime = value;
-							break;
-						}
-                        case kParamSustainVolume:
-                        {
-                            paramState.sustainVolume = value;
-                            break;
-                        }
-                        case kParamDecayTime:
-                        {
-                            paramState.decayTime = value;
-                            break;
-                        }
-						case kParamSinusDetune:
-						{
-							paramState.sinusDetune = 2 * (value - 0.5);
-							break;
-						}
-
-						case kParamTriangleSlop:
-						{
-							paramState.triangleSlop = value;
-							break;
-						}
-                        case kParamTriangleSlopTwo:
-                        {
-                            paramState.triangleSlopTwo = value;
-                            break;
-                        }
-                        case kParamGenFreqOne:
-                        {
-                            paramState.genFreqOne = value;
-                            break;
-                        }
-                        case kParamGenFreqTwo:
-                        {
-                            paramState.genFreqTwo = value;
-                            break;
-                        }
-                        case kParamStereoMs:
-                        {
-                            paramState.stereoMs = value;
-                            break;
-                        }
-						case kParamFreqModOn:
-						{
-							paramState.freqModOn = value;
-							break;
-						}
-						case kParamSaveState:
-						{
-							//voice.save();
-							std::ofstream myfile("D:/Documents/values.txt");
-							std::string data(std::to_string(paramState.masterVolume));
-							myfile << data;
-							myfile.flush();
-							myfile.close();
-							break;
-						}
-						case kParamLoadState:
-						{
-							std::string line;
-							std::ifstream myfile("D:/Documents/values.txt");
-							while (std::getline(myfile, line))
-							{
-								paramState.masterVolume = std::stof(line);
-								if (data.outputParameterChanges)
-								{
-									int32 index;
-									IParamValueQueue* queue =
-										data.outputParameterChanges->addParameterData(kParamMasterVolume, index);
-									if (queue)
-									{
-										queue->addPoint(
-											0, paramState.masterVolume, index);
-									}
-								}
-							}
-							myfile.close();
-							break;
-						}
-						case kParamFilePath:
-						{
-							paramState.filePath = value;
-							break;
-						}
-						case kParamFilterType:
-						{
-							paramState.filterType = std::min<int8> (
-							    (int8) (NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1);
-							break;
-						}
-                        case kParamOscType:
-                        {
-                            paramState.oscType = std::min<int8> (
-                                                                 (int8) (NUM_OSC_TYPE * value), NUM_OSC_TYPE - 1);
-                            break;
-                        }
-                        case kParamOscTypeTwo:
-                        {
-                            paramState.oscTypeTwo = std::min<int8> (
-                                                                    (int8) (NUM_OSC_TYPE_TWO * value), NUM_OSC_TYPE_TWO - 1);
-                            break;
-                        }
-						case kParamFilterFreq:
-						{
-							paramState.filterFreq = value;
-							break;
-						}
-						case kParamFilterQ:
-						{
-							paramState.filterQ = value;
-							break;
-						}
-                        case kParamFilterOneType:
-                        {
-                            paramState.filterOneType = std::min<int8> (
-                                                                    (int8) (NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1);
-                            break;
-                        }
-                        case kParamFilterOneFreq:
-                        {
-                            paramState.filterOneFreq = value;
-                            break;
-                        }
-                        case kParamFilterOneQ:
-                        {
-                            paramState.filterOneQ = value;
-                            break;
-                        }
-                        case kParamFilterTwoType:
-                        {
-                            paramState.filterTwoType = std::min<int8> (
-                                                                    (int8) (NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1);
-                            break;
-                        }
-                        case kParamFilterTwoFreq:
-                        {
-                            paramState.filterTwoFreq = value;
-                            break;
-                        }
-                        case kParamFilterTwoQ:
-                        {
-                            paramState.filterTwoQ = value;
-                            break;
-                        }
-						case kParamBypassSNA:
-						{
-							paramState.bypassSNA = (value >= 0.5) ? 1 : 0;
-							break;
-						}
-						case kParamTuningRange:
-						{
-							paramState.tuningRange = std::min<int8> (
-							    (int8) (NUM_TUNING_RANGE * value), NUM_TUNING_RANGE - 1);
-							break;
-						}
-					}
-				}
-			}
-		}
+		paramState.tuning = tuningTable;
+		// the voices derive their frequencies from the table like from the master tuning
+		paramState.changedParameters |= (uint64)1 << kParamMasterTuning;
+		paramState.generation++;
 	}
+	// picks up setState and tuning, further snapshots follow each automation step
+	paramSnapshots.publish (paramState);
+
 	tresult result;
 
 	// flush mode
 	if (data.numOutputs < 1)
 		result = kResultTrue;
 	else
-		result = voiceProcessor->process (data);
+	{
+		result = voiceProcessor->process (data, &automation);
+		// every playing voice has seen the changes, the final automation values of this block
+		// (automation.end) and anything until the next block are flagged anew
+		paramState.changedParameters = 0;
+		if (result == kResultTrue)
+			processStereoDelay (data);
+	}
+	automation.end ();
+	// once the morph lane rests the controller gets the values it left behind, one point per field
+	if (!morphMoving && unreportedMorph)
+		reportMorphedParameters ();
+	outputParameterChanges = nullptr;
+
+	std::chrono::duration<double> renderTime = std::chrono::steady_clock::now () - renderStart;
+	updateCpuGovernor (data, renderTime.count ());
+
 	if (result == kResultTrue)
 	{
+		if (data.numOutputs > 0)
+			pushTelemetry (data, renderTime.count ());
 		if (data.outputParameterChanges)
 		{
 			int32 index;
@@ -481,17 +351,327 @@ tresult PLUGIN_API Processor::process (ProcessData& data)
 			if (queue)
 			{
 				queue->addPoint (
-				    0, (ParamValue)voiceProcessor->getActiveVoices () / (ParamValue)MAX_VOICES,
+				    0, (ParamValue)voiceProcessor->getActiveVoices () / (ParamValue)MAX_POLYPHONY,
 				    index);
 			}
 		}
-		if (voiceProcessor->getActiveVoices () == 0 && data.numOutputs > 0)
+		if (voiceProcessor->getActiveVoices () == 0 && stereoDelayTail <= 0 && data.numOutputs > 0)
 		{
 			data.outputs[0].silenceFlags = 0x11; // left and right channel are silent
 		}
 	}
 	return result;
 }
+
+//-----------------------------------------------------------------------------
+tresult PLUGIN_API Processor::notify (IMessage* message)
+{
+	if (message == nullptr)
+		return kInvalidArgument;
+
+	if (strcmp (message->getMessageID (), kPresetBankMessageID) == 0)
+	{
+		const void* path = nullptr;
+		uint32 pathSize = 0;
+		if (message->getAttributes ()->getBinary (kPresetBankPathAttr, path, pathSize) != kResultTrue)
+			return kInvalidArgument;
+		PresetBank* bank = new PresetBank;
+		if (!bank->open (std::string ((const char*)path, pathSize).c_str ()))
+		{
+			delete bank;
+			return kResultFalse;
+		}
+		presetBanks.publish (bank);
+		return kResultOk;
+	}
+
+	if (strcmp (message->getMessageID (), kTuningMessageID) != 0)
+		return AudioEffect::notify (message);
+
+	const void* scale = nullptr;
+	uint32 scaleSize = 0;
+	if (message->getAttributes ()->getBinary (kTuningScaleAttr, scale, scaleSize) != kResultTrue)
+		return kInvalidArgument;
+	const void* keyboardMapping = nullptr;
+	uint32 keyboardMappingSize = 0;
+	message->getAttributes ()->getBinary (kTuningKeyboardMappingAttr, keyboardMapping, keyboardMappingSize);
+
+	Tuning newTuning;
+	if (!newTuning.parseScale ((const char*)scale, (int32)scaleSize) ||
+	    !newTuning.parseKeyboardMapping ((const char*)keyboardMapping, (int32)keyboardMappingSize))
+		return kInvalidArgument;
+	tuning = newTuning;
+
+	// the audio thread picks it up with its next block
+	if (processSetup.sampleRate > 0.)
+		tuningTables.publish (tuning.createTable (processSetup.sampleRate));
+	return kResultOk;
+}
+
+//-----------------------------------------------------------------------------
+tresult PLUGIN_API Processor::connect (IConnectionPoint* other)
+{
+	tresult result = AudioEffect::connect (other);
+	if (result != kResultTrue)
+		return result;
+
+	// only a controller in this process finds the key, it checks the process id
+	if (telemetryKey == 0)
+		telemetryKey = TelemetryChannel::announce (telemetry);
+	IPtr<IMessage> message = owned (allocateMessage ());
+	if (message)
+	{
+		message->setMessageID (kTelemetryMessageID);
+		message->getAttributes ()->setInt (kTelemetryKeyAttr, telemetryKey);
+		message->getAttributes ()->setInt (kTelemetryProcessAttr, TelemetryChannel::getProcessId ());
+		sendMessage (message);
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+tresult PLUGIN_API Processor::disconnect (IConnectionPoint* other)
+{
+	// a controller which already took the channel keeps it, later lookups fail
+	if (telemetryKey != 0)
+	{
+		TelemetryChannel::withdraw (telemetryKey);
+		telemetryKey = 0;
+	}
+	return AudioEffect::disconnect (other);
+}
+
+//-----------------------------------------------------------------------------
+template<class Sample>
+static void measureChannel (const Sample* samples, int32 numSamples, float& peak, float& rms)
+{
+	Sample maxAbs = 0;
+	double sumSquares = 0.;
+	for (int32 i = 0; i < numSamples; i++)
+	{
+		maxAbs = std::max (maxAbs, (Sample)std::abs (samples[i]));
+		sumSquares += (double)samples[i] * samples[i];
+	}
+	peak = (float)maxAbs;
+	rms = numSamples > 0 ? (float)std::sqrt (sumSquares / numSamples) : 0.f;
+}
+
+//-----------------------------------------------------------------------------
+void Processor::pushTelemetry (ProcessData& data, double renderSeconds)
+{
+	TelemetryRecord record {};
+	int32 numChannels = std::min<int32> (data.outputs[0].numChannels, TelemetryRecord::kNumChannels);
+	for (int32 c = 0; c < numChannels; c++)
+	{
+		if (data.symbolicSampleSize == kSample32)
+			measureChannel (data.outputs[0].channelBuffers32[c], data.numSamples, record.peak[c], record.rms[c]);
+		else
+			measureChannel (data.outputs[0].channelBuffers64[c], data.numSamples, record.peak[c], record.rms[c]);
+	}
+	record.renderTime = (float)renderSeconds;
+	if (data.numSamples > 0)
+		record.renderLoad = (float)(renderSeconds * processSetup.sampleRate / data.numSamples);
+	record.activeVoices = voiceProcessor->getActiveVoices ();
+	record.numVoiceLevels = voiceProcessor->getVoiceLevels (record.voiceLevels, TelemetryRecord::kMaxVoiceLevels);
+
+	// the stats of the pool are from an earlier block when it did not run in this one
+	uint32 numRuns = renderPool.getNumRuns ();
+	if (numRuns != telemetryRuns && data.numSamples > 0)
+	{
+		static_assert (TelemetryRecord::kMaxWorkers >= RenderPool::kMaxThreads + 1, "too few workers in TelemetryRecord");
+		record.numWorkers = renderPool.getNumWorkers ();
+		for (int32 i = 0; i < record.numWorkers; i++)
+		{
+			record.workerLoad[i] = (float)(renderPool.getWorkerNanos (i) * 1e-9 * processSetup.sampleRate / data.numSamples);
+			record.workerTasks[i] = renderPool.getWorkerTasks (i);
+		}
+	}
+	telemetryRuns = numRuns;
+
+	// dropped while no editor drains the channel
+	telemetry->push (record);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::updateCpuGovernor (ProcessData& data, double renderSeconds)
+{
+	// offline rendering has no deadline
+	CpuGovernor::Level level = CpuGovernor::kFullQuality;
+	if (data.processMode != kOffline && data.numSamples > 0)
+		level = cpuGovernor.update (renderSeconds * processSetup.sampleRate / data.numSamples);
+	else
+		cpuGovernor.reset ();
+
+	// the voices see the new level with the next snapshot
+	paramState.renderQuality = (int8)level;
+
+	if (level != reportedRenderQuality && data.outputParameterChanges)
+	{
+		int32 index;
+		IParamValueQueue* queue = data.outputParameterChanges->addParameterData (kParamCpuGovernor, index);
+		if (queue)
+		{
+			queue->addPoint (0, (ParamValue)level / (ParamValue)(CpuGovernor::kNumLevels - 1), index);
+			reportedRenderQuality = level;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Processor::applyParameter (ParamID pid, ParamValue value)
+{
+	const ParameterDescriptor* desc = kParameterDescriptorIndex.find (pid);
+	if (desc == nullptr)
+		return;
+
+	if (desc->transform != ParameterDescriptor::kTrigger)
+	{
+		desc->apply (paramState, value);
+		paramState.changedParameters |= (uint64)1 << pid;
+		paramState.generation++;
+		// every automation step of the morph lane moves all morphed fields with it
+		if (pid == kParamMorph)
+		{
+			uint64 morphed = presetMorph.apply (paramState.morph, paramState);
+			paramState.changedParameters |= morphed;
+			unreportedMorph |= morphed;
+			morphMoving |= morphed != 0;
+		}
+		return;
+	}
+
+	// the triggers only post a request, the worker thread does the file I/O
+	switch (pid)
+	{
+		case kParamSaveState:
+		{
+			// on the rising edge, automation calls this for every step of a ramp
+			if (value >= 0.5 && paramState.saveState < 0.5)
+				presetWorker.requestSave (paramState);
+			paramState.saveState = value;
+			break;
+		}
+		case kParamLoadState:
+		{
+			if (value >= 0.5 && paramState.loadState < 0.5)
+				presetWorker.requestLoad (paramState);
+			paramState.loadState = value;
+			break;
+		}
+		case kParamMorphStoreA:
+		{
+			if (value >= 0.5 && paramState.morphStoreA < 0.5)
+				presetMorph.store (PresetMorph::kSlotA, paramState);
+			paramState.morphStoreA = value;
+			break;
+		}
+		case kParamMorphStoreB:
+		{
+			if (value >= 0.5 && paramState.morphStoreB < 0.5)
+				presetMorph.store (PresetMorph::kSlotB, paramState);
+			paramState.morphStoreB = value;
+			break;
+		}
+		case kParamBankPreset:
+		{
+			// the record is already in memory, the next snapshot switches the voices over
+			int32 preset = (int32)(value * (MAX_BANK_PRESETS - 1) + 0.5);
+			// every point of a ramp lands here, only a new index replaces the edited sound
+			if (presetBank && preset != appliedBankPreset)
+			{
+				appliedBankPreset = preset;
+				presetBank->getPreset (preset, [this] (const ParameterDescriptor& desc, ParamValue normalized) {
+					setStoredParameter (desc, normalized);
+				});
+			}
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Processor::applyLoadedPreset ()
+{
+	GlobalParameterState loaded;
+	if (!presetWorker.fetchLoaded (loaded))
+		return;
+
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (desc.stateVersion != ParameterDescriptor::kNotStored)
+			setStoredParameter (desc, desc.getNormalized (loaded));
+	}
+	// like setState, the next automation ramps start from the loaded values
+	automation.reset ();
+}
+
+//-----------------------------------------------------------------------------
+void Processor::setStoredParameter (const ParameterDescriptor& desc, ParamValue value)
+{
+	// a preset only touches what differs, and reports it to the controller
+	if (desc.transform == ParameterDescriptor::kTrigger || value == desc.getNormalized (paramState))
+		return;
+	desc.apply (paramState, value);
+	paramState.changedParameters |= (uint64)1 << desc.id;
+	paramState.generation++;
+	if (outputParameterChanges)
+	{
+		int32 index;
+		IParamValueQueue* queue = outputParameterChanges->addParameterData (desc.id, index);
+		if (queue)
+			queue->addPoint (0, value, index);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Processor::reportMorphedParameters ()
+{
+	if (outputParameterChanges == nullptr)
+		return;
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if ((unreportedMorph & ((uint64)1 << desc.id)) == 0)
+			continue;
+		int32 index;
+		IParamValueQueue* queue = outputParameterChanges->addParameterData (desc.id, index);
+		if (queue)
+			queue->addPoint (0, desc.getNormalized (paramState), index);
+	}
+	unreportedMorph = 0;
+}
+
+//-----------------------------------------------------------------------------
+void Processor::endParameterChanges ()
+{
+	paramSnapshots.publish (paramState);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::processStereoDelay (ProcessData& data)
+{
+	// the voices write a dry right channel, the offset is applied once here for the whole mix
+	ParamValue delaySamples = paramState.stereoMs * MAX_STEREO_DELAY_SEC * processSetup.sampleRate;
+	if (data.symbolicSampleSize == kSample32)
+	{
+		stereoDelay32.setDelay (delaySamples);
+		Sample32* right = data.outputs[0].channelBuffers32[1];
+		for (int32 i = 0; i < data.numSamples; i++)
+			right[i] = stereoDelay32.process (right[i]);
+	}
+	else
+	{
+		stereoDelay64.setDelay (delaySamples);
+		Sample64* right = data.outputs[0].channelBuffers64[1];
+		for (int32 i = 0; i < data.numSamples; i++)
+			right[i] = stereoDelay64.process (right[i]);
+	}
+
+	// keep reporting sound until the delayed right channel has drained
+	if (voiceProcessor->getActiveVoices () > 0)
+		stereoDelayTail = (int32)delaySamples + 1;
+	else
+		stereoDelayTail -= data.numSamples;
+}
 } // NoteExpressionSynth
 } // Vst
 } // Steinberg
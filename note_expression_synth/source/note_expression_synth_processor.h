@@ -38,20 +38,30 @@
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include "note_expression_synth_voice.h"
+#include "delayline.h"
+#include "parameterautomation.h"
+#include "parametersnapshot.h"
+#include "renderpool.h"
+#include "cpugovernor.h"
+#include "tuning.h"
+#include "presetworker.h"
+#include "presetbank.h"
+#include "presetmorph.h"
+#include "telemetry.h"
 
 namespace Steinberg {
 namespace Vst {
-class VoiceProcessor;
-
 namespace NoteExpressionSynth {
 
+class SynthVoiceProcessor;
+
 //-----------------------------------------------------------------------------
 /** Example Note Expression Audio Processor
 
-\sa Steinberg::Vst::VoiceProcessor
+\sa SynthVoiceProcessor
 \sa Steinberg::Vst::VoiceBase
 */
-class Processor : public AudioEffect
+class Processor : public AudioEffect, public IParameterTarget
 {
 public:
 	Processor ();
@@ -66,14 +76,51 @@ public:
 	tresult PLUGIN_API setActive (TBool state) SMTG_OVERRIDE;
 	tresult PLUGIN_API process (ProcessData& data) SMTG_OVERRIDE;
 
-	Voice<float> voice;
-	
+	/** kTuningMessageID: parses the Scala files and hands the new table to the audio thread,
+		kPresetBankMessageID: maps the bank file for kParamBankPreset */
+	tresult PLUGIN_API notify (IMessage* message) SMTG_OVERRIDE;
+	/** announces the TelemetryChannel to the controller while they are connected */
+	tresult PLUGIN_API connect (IConnectionPoint* other) SMTG_OVERRIDE;
+	tresult PLUGIN_API disconnect (IConnectionPoint* other) SMTG_OVERRIDE;
+
 	static FUnknown* createInstance (void*) { return (IAudioProcessor*)new Processor (); }
 
 	static FUID cid;
 protected:
-	VoiceProcessor* voiceProcessor;
-	GlobalParameterState paramState;
+	void applyParameter (ParamID pid, ParamValue value) SMTG_OVERRIDE;
+	void endParameterChanges () SMTG_OVERRIDE;
+	void processStereoDelay (ProcessData& data);
+	void updateCpuGovernor (ProcessData& data, double renderSeconds);
+	void pushTelemetry (ProcessData& data, double renderSeconds);
+	void applyLoadedPreset ();
+	void setStoredParameter (const ParameterDescriptor& desc, ParamValue value);
+	void reportMorphedParameters ();
+
+	SynthVoiceProcessor* voiceProcessor;
+	GlobalParameterState paramState;				// working copy, process thread only
+	ParameterSnapshots<GlobalParameterState> paramSnapshots;	// what the voices read
+	ParameterAutomation automation;
+	IParameterChanges* outputParameterChanges;
+	RenderPool renderPool;		// kParamRenderThreads workers, started at setActive
+	CpuGovernor cpuGovernor;
+	int32 reportedRenderQuality;	// last level sent as kParamCpuGovernor
+	Tuning tuning;					// message thread only
+	TuningTableExchange tuningTables;	// tuning at processSetup.sampleRate
+	PresetWorker<GlobalParameterState> presetWorker;	// kParamSaveState, kParamLoadState
+	PointerExchange<PresetBank> presetBanks;
+	const PresetBank* presetBank;	// acquired for the current block
+	int32 appliedBankPreset;		// kParamBankPreset index presetBank was last applied with
+	PresetMorph presetMorph;		// kParamMorph, kParamMorphStoreA, kParamMorphStoreB
+	uint64 unreportedMorph;			// fields moved by the morph, not yet sent to the controller
+	bool morphMoving;				// the morph changed fields in the current block
+	IPtr<TelemetryChannel> telemetry;	// one record per block for the editor meters
+	uint32 telemetryRuns;				// RenderPool::getNumRuns at the last record
+	int64 telemetryKey;					// TelemetryChannel::announce, 0 while not connected
+
+	// master bus offset of the right channel (kParamStereoMs)
+	DelayLine<float> stereoDelay32;
+	DelayLine<double> stereoDelay64;
+	int32 stereoDelayTail;
 };
 
 }}} // namespaces
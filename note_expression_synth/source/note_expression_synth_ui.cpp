@@ -37,12 +37,17 @@
 
 #include "note_expression_synth_ui.h"
 #include "vstgui/contrib/keyboardview.h"
+#include "vstgui/lib/cfileselector.h"
 #include "vstgui/plugin-bindings/vst3groupcontroller.h"
 #include "vstgui/plugin-bindings/vst3padcontroller.h"
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstinterappaudio.h"
 #include "pluginterfaces/vst/ivstpluginterfacesupport.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 
 using namespace VSTGUI;
 
@@ -296,6 +301,110 @@ namespace Vst {
 			KeyboardViewRangeSelector::Range& selectedRange;
 		};
 
+		//------------------------------------------------------------------------
+		static bool hasExtension(const std::string& path, const char* extension)
+		{
+			size_t length = strlen(extension);
+			if (path.size() <= length || path[path.size() - length - 1] != '.')
+				return false;
+			for (size_t i = 0; i < length; i++)
+			{
+				if (tolower((unsigned char)path[path.size() - length + i]) != extension[i])
+					return false;
+			}
+			return true;
+		}
+
+		//------------------------------------------------------------------------
+		/** Buttons which open a file selector and hand the chosen files to the controller. */
+		class FileLoadController : public IController
+		{
+		public:
+			enum
+			{
+				kLoadTuning = 5010,
+				kLoadPresetBank
+			};
+
+			FileLoadController(VST3Editor* editor, Controller* controller)
+				: editor(editor), controller(controller)
+			{
+			}
+
+			void valueChanged(VSTGUI::CControl* pControl) override
+			{
+				// kick style buttons, only the press opens a selector
+				if (pControl->getValue() == 0.f)
+					return;
+				switch (pControl->getTag())
+				{
+				case kLoadTuning:
+				{
+					runLoadTuning();
+					break;
+				}
+				case kLoadPresetBank:
+				{
+					runLoadPresetBank();
+					break;
+				}
+				}
+			}
+
+		private:
+			SharedPointer<CNewFileSelector> createSelector(UTF8StringPtr title)
+			{
+				auto selector = VSTGUI::owned(CNewFileSelector::create(editor->getFrame(), CNewFileSelector::kSelectFile));
+				if (selector)
+					selector->setTitle(title);
+				return selector;
+			}
+
+			void runLoadTuning()
+			{
+				auto selector = createSelector("Load Tuning");
+				if (!selector)
+					return;
+				// the scale and, optionally, its keyboard mapping are picked together
+				selector->addFileExtension(CFileExtension("Scala Scale", "scl"));
+				selector->addFileExtension(CFileExtension("Scala Keyboard Mapping", "kbm"));
+				selector->setAllowMultiFileSelection(true);
+				// the selector may answer after the editor closed, the controller is kept alive
+				IPtr<Controller> target(controller);
+				selector->run([target](CNewFileSelector* selector) {
+					std::string scalePath;
+					std::string keyboardMappingPath;
+					for (uint32_t i = 0; i < selector->getNumSelectedFiles(); i++)
+					{
+						std::string path(selector->getSelectedFile(i));
+						if (hasExtension(path, "kbm"))
+							keyboardMappingPath = path;
+						else
+							scalePath = path;
+					}
+					// a keyboard mapping alone has no scale to map
+					if (!scalePath.empty())
+						target->loadTuning(scalePath.c_str(), keyboardMappingPath.empty() ? nullptr : keyboardMappingPath.c_str());
+				});
+			}
+
+			void runLoadPresetBank()
+			{
+				auto selector = createSelector("Load Preset Bank");
+				if (!selector)
+					return;
+				// banks have no extension of their own, PresetBank::open checks the header
+				IPtr<Controller> target(controller);
+				selector->run([target](CNewFileSelector* selector) {
+					if (selector->getNumSelectedFiles() > 0)
+						target->loadPresetBank(selector->getSelectedFile(0));
+				});
+			}
+
+			VST3Editor* editor;
+			Controller* controller;
+		};
+
 		//------------------------------------------------------------------------
 		FUID ControllerWithUI::cid(0x1AA302B3, 0xE8384785, 0xB9C3FE3E, 0x08B056F5);
 		FUID ProcessorWithUIController::cid(0x41466D9B, 0xB0654576, 0xB641098F, 0x686371B3);
@@ -303,7 +412,74 @@ namespace Vst {
 		enum
 		{
 			kParamMIDILearn = kNumGlobalParameters,
-			kParamEnableMPE
+			kParamEnableMPE,
+
+			// meters set from the TelemetryChannel, never sent to the host
+			kParamPeakLeft,
+			kParamPeakRight,
+			kParamRmsLeft,
+			kParamRmsRight,
+			kParamRenderLoad,
+			kParamWorkerLoad	// the busiest RenderPool thread
+		};
+
+		static const uint32 kTelemetryInterval = 16;	// ms, about one display frame
+		static const double kMeterRangeDb = 60.;		// meters show [-kMeterRangeDb, 0] dB
+
+		//------------------------------------------------------------------------
+		static ParamValue meterLevel (float gain)
+		{
+			if (gain <= 0.f)
+				return 0.;
+			ParamValue db = 20. * std::log10 ((double)gain);
+			return std::min (std::max ((db + kMeterRangeDb) / kMeterRangeDb, 0.), 1.);
+		}
+
+		//------------------------------------------------------------------------
+		/** One bar per playing voice, from the envelope levels of the last TelemetryRecord. */
+		class VoiceLevelView : public CView
+		{
+		public:
+			VoiceLevelView(const CRect& size, const ControllerWithUI* controller)
+				: CView(size), controller(controller)
+			{
+			}
+
+			void draw(CDrawContext* context) override
+			{
+				const TelemetryRecord& record = controller->getTelemetry();
+				CRect bounds = getViewSize();
+				context->setFillColor(kBlackCColor);
+				context->drawRect(bounds, kDrawFilled);
+				context->setFillColor(kGreenCColor);
+				CCoord width = bounds.getWidth() / TelemetryRecord::kMaxVoiceLevels;
+				for (int32 i = 0; i < record.numVoiceLevels; i++)
+				{
+					CCoord height = bounds.getHeight() * std::min(record.voiceLevels[i], 1.f);
+					CRect bar(bounds.left + i * width, bounds.bottom - height,
+						bounds.left + (i + 1) * width - 1, bounds.bottom);
+					context->drawRect(bar, kDrawFilled);
+				}
+				setDirty(false);
+			}
+
+			// redrawn at the rate the controller drains the telemetry, while it is on screen
+			bool attached(CView* parent) override
+			{
+				redrawTimer = makeOwned<CVSTGUITimer>([this](CVSTGUITimer*) { invalid(); }, kTelemetryInterval);
+				return CView::attached(parent);
+			}
+			bool removed(CView* parent) override
+			{
+				if (redrawTimer)
+					redrawTimer->stop();
+				redrawTimer = nullptr;
+				return CView::removed(parent);
+			}
+
+		private:
+			const ControllerWithUI* controller;
+			SharedPointer<CVSTGUITimer> redrawTimer;
 		};
 
 		//------------------------------------------------------------------------
@@ -325,6 +501,14 @@ namespace Vst {
 					parameters.addParameter(USTRING("Enable MPE"), nullptr, 1, 0,
 						ParameterInfo::kCanAutomate, kParamEnableMPE);
 				}
+
+				int32 meterFlags = ParameterInfo::kIsReadOnly | ParameterInfo::kIsHidden;
+				parameters.addParameter(USTRING("Peak Left"), nullptr, 0, 0, meterFlags, kParamPeakLeft);
+				parameters.addParameter(USTRING("Peak Right"), nullptr, 0, 0, meterFlags, kParamPeakRight);
+				parameters.addParameter(USTRING("RMS Left"), nullptr, 0, 0, meterFlags, kParamRmsLeft);
+				parameters.addParameter(USTRING("RMS Right"), nullptr, 0, 0, meterFlags, kParamRmsRight);
+				parameters.addParameter(USTRING("Render Load"), nullptr, 0, 0, meterFlags, kParamRenderLoad);
+				parameters.addParameter(USTRING("Worker Load"), nullptr, 0, 0, meterFlags, kParamWorkerLoad);
 			}
 			return result;
 		}
@@ -335,6 +519,8 @@ namespace Vst {
 			if (playerDelegate)
 				delete playerDelegate;
 			playerDelegate = nullptr;
+			telemetryTimer = nullptr;
+			telemetry = nullptr;
 			return Controller::terminate();
 		}
 
@@ -425,6 +611,10 @@ IController* ControllerWithUI::createSubController (UTF8StringPtr _name,
 #endif
 		return new ConditionalRemoveViewController (editor, mpeSupportNeeded);
 	}
+	else if (name == "FileLoadController")
+	{
+		return new FileLoadController (editor, this);
+	}
 	else if (name == "MidiLearnController")
 	{
 #if DEVELOPMENT
@@ -508,6 +698,15 @@ tresult ControllerWithUI::endEdit (ParamID tag)
 	return Controller::endEdit (tag);
 }
 
+//------------------------------------------------------------------------
+CView* ControllerWithUI::createCustomView (UTF8StringPtr name, const UIAttributes& attributes,
+                                           const IUIDescription* description, VST3Editor* editor)
+{
+	if (ConstString (name) == "VoiceLevels")
+		return new VoiceLevelView (CRect (0, 0, 0, 0), this);
+	return nullptr;
+}
+
 //------------------------------------------------------------------------
 tresult PLUGIN_API ControllerWithUI::onLiveMIDIControllerInput (int32 busIndex, int16 channel,
                                                                 CtrlNumber midiCC)
@@ -536,6 +735,68 @@ bool ControllerWithUI::isPrivateParameter (const ParamID paramID)
 	return paramID >= kParamMIDILearn;
 }
 
+//------------------------------------------------------------------------
+tresult PLUGIN_API ControllerWithUI::notify (IMessage* message)
+{
+	if (message == nullptr || strcmp (message->getMessageID (), kTelemetryMessageID) != 0)
+		return Controller::notify (message);
+
+	int64 key = 0;
+	int64 process = 0;
+	if (message->getAttributes ()->getInt (kTelemetryKeyAttr, key) != kResultTrue ||
+	    message->getAttributes ()->getInt (kTelemetryProcessAttr, process) != kResultTrue)
+		return kInvalidArgument;
+	// the processor runs in another process, the meters stay at rest
+	if (process != TelemetryChannel::getProcessId ())
+		return kResultFalse;
+	// nullptr when the processor disconnected before the host delivered the message
+	telemetry = TelemetryChannel::find (key);
+	return telemetry ? kResultOk : kResultFalse;
+}
+
+//------------------------------------------------------------------------
+tresult PLUGIN_API ControllerWithUI::disconnect (IConnectionPoint* other)
+{
+	telemetry = nullptr;
+	return Controller::disconnect (other);
+}
+
+//------------------------------------------------------------------------
+void ControllerWithUI::didOpen (VST3Editor* editor)
+{
+	if (numOpenEditors++ == 0)
+		telemetryTimer = makeOwned<CVSTGUITimer> ([this] (CVSTGUITimer*) { updateTelemetry (); },
+		                                          kTelemetryInterval);
+}
+
+//------------------------------------------------------------------------
+void ControllerWithUI::willClose (VST3Editor* editor)
+{
+	if (--numOpenEditors == 0)
+	{
+		telemetryTimer->stop ();
+		telemetryTimer = nullptr;
+	}
+}
+
+//------------------------------------------------------------------------
+void ControllerWithUI::updateTelemetry ()
+{
+	// every block since the last frame folded into one, the host is not involved
+	if (!telemetry || !telemetry->drain (telemetryRecord))
+		return;
+	setParamNormalized (kParamPeakLeft, meterLevel (telemetryRecord.peak[0]));
+	setParamNormalized (kParamPeakRight, meterLevel (telemetryRecord.peak[1]));
+	setParamNormalized (kParamRmsLeft, meterLevel (telemetryRecord.rms[0]));
+	setParamNormalized (kParamRmsRight, meterLevel (telemetryRecord.rms[1]));
+	setParamNormalized (kParamRenderLoad, std::min<ParamValue> (telemetryRecord.renderLoad, 1.));
+	// a worker near the deadline while the others idle asks for a different kParamRenderThreads
+	float workerLoad = 0.f;
+	for (int32 i = 0; i < telemetryRecord.numWorkers; i++)
+		workerLoad = std::max (workerLoad, telemetryRecord.workerLoad[i]);
+	setParamNormalized (kParamWorkerLoad, std::min<ParamValue> (workerLoad, 1.));
+}
+
 //------------------------------------------------------------------------
 ProcessorWithUIController::ProcessorWithUIController ()
 {
@@ -39,7 +39,9 @@
 
 #include "note_expression_synth_controller.h"
 #include "note_expression_synth_processor.h"
+#include "telemetry.h"
 #include "vstgui/contrib/keyboardview.h"
+#include "vstgui/lib/cvstguitimer.h"
 #include "vstgui/plugin-bindings/vst3editor.h"
 
 
@@ -67,15 +69,25 @@ public:
 	tresult beginEdit (ParamID tag) SMTG_OVERRIDE;
 	tresult performEdit (ParamID tag, ParamValue valueNormalized) SMTG_OVERRIDE;
 	tresult endEdit (ParamID tag) SMTG_OVERRIDE;
+	/** kTelemetryMessageID: takes the TelemetryChannel of a processor in this process */
+	tresult PLUGIN_API notify (IMessage* message) SMTG_OVERRIDE;
+	tresult PLUGIN_API disconnect (IConnectionPoint* other) SMTG_OVERRIDE;
+
+	/** the telemetry drained last, for views which draw more than the meter parameters */
+	const TelemetryRecord& getTelemetry () const { return telemetryRecord; }
 
 	//--- IMidiLearn ---------------------------------
 	tresult PLUGIN_API onLiveMIDIControllerInput (int32 busIndex, int16 channel,
 	                                              CtrlNumber midiCC) SMTG_OVERRIDE;
 
 	// VST3EditorDelegate
+	VSTGUI::CView* createCustomView (UTF8StringPtr name, const VSTGUI::UIAttributes& attributes,
+	                                 const IUIDescription* description, VST3Editor* editor) SMTG_OVERRIDE;
 	IController* createSubController (UTF8StringPtr name, const IUIDescription* description,
 	                                  VST3Editor* editor) SMTG_OVERRIDE;
 	bool isPrivateParameter (const ParamID paramID) SMTG_OVERRIDE;
+	void didOpen (VST3Editor* editor) SMTG_OVERRIDE;
+	void willClose (VST3Editor* editor) SMTG_OVERRIDE;
 	
 	static FUnknown* createInstance (void*) { return (IEditController*)new ControllerWithUI (); }
 
@@ -87,10 +99,17 @@ public:
 	REFCOUNT_METHODS (Controller)
 
 private:
+	void updateTelemetry ();
+
 	VSTGUI::IKeyboardViewPlayerDelegate* playerDelegate {nullptr};
 	VSTGUI::KeyboardViewRangeSelector::Range keyboardRange {};
 	ParamID midiLearnParamID {InvalidParamID};
 	bool doMIDILearn {false};
+
+	IPtr<TelemetryChannel> telemetry;
+	TelemetryRecord telemetryRecord {};
+	VSTGUI::SharedPointer<VSTGUI::CVSTGUITimer> telemetryTimer;	// while an editor is open
+	int32 numOpenEditors {0};
 };
 
 //-----------------------------------------------------------------------------
@@ -35,226 +35,158 @@
 //-----------------------------------------------------------------------------
 
 #include "note_expression_synth_voice.h"
+#include "parameterdescriptors.h"
 #include "base/source/fstreamer.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Steinberg {
 namespace Vst {
 namespace NoteExpressionSynth {
 
-static uint64 currentParamStateVersion = 3;
+//-----------------------------------------------------------------------------
+// State stream since the bulk record, little endian:
+//	uint32 magic, uint32 version			the first 8 bytes of older streams are a uint64 version
+//	uint32 recordSize, uint32 checksum		FNV-1a of the record
+//	record									stateRecordSize (version) bytes
+static constexpr uint32 kStateMagic = 0x5353454E;	// "NESS"
+static constexpr uint32 kStateHeaderSize = 16;
 
 //-----------------------------------------------------------------------------
-tresult GlobalParameterState::setState (IBStream* stream)
+template<class T>
+static inline void storeLittleEndian (char* dst, T value)
+{
+	memcpy (dst, &value, sizeof (T));
+#if BYTEORDER == kBigEndian
+	std::reverse (dst, dst + sizeof (T));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+template<class T>
+static inline T loadLittleEndian (const char* src)
+{
+	T value;
+#if BYTEORDER == kBigEndian
+	char bytes[sizeof (T)];
+	std::reverse_copy (src, src + sizeof (T), bytes);
+	memcpy (&value, bytes, sizeof (T));
+#else
+	memcpy (&value, src, sizeof (T));
+#endif
+	return value;
+}
+
+//-----------------------------------------------------------------------------
+static uint32 stateChecksum (const char* data, uint32 size)
+{
+	uint32 hash = 2166136261u;
+	for (uint32 i = 0; i < size; i++)
+		hash = (hash ^ (uint8)data[i]) * 16777619u;
+	return hash;
+}
+
+//-----------------------------------------------------------------------------
+/** streams up to version 7 wrote one value per field after the version */
+static tresult readFieldByField (GlobalParameterState& state, IBStream* stream, uint64 version)
 {
 	IBStreamer s (stream, kLittleEndian);
-	uint64 version = 0;
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (desc.stateVersion == ParameterDescriptor::kNotStored || (uint64)desc.stateVersion > version)
+			continue;
+		if (!(desc.value ? s.readDouble (state.*desc.value) : s.readInt8 (state.*desc.step)))
+			return kResultFalse;
+	}
+	return kResultTrue;
+}
 
-	// version 0
-	if (!s.readInt64u (version))
-		return kResultFalse;
-	if (!s.readDouble (noiseVolume))
-		return kResultFalse;
-    if (!s.readDouble (noiseVolumeTwo))
-        return kResultFalse;
-	if (!s.readDouble (sinusVolume))
-		return kResultFalse;
-    if (!s.readDouble (sinusVolumeTwo))
-        return kResultFalse;
-	if (!s.readDouble (triangleVolume))
-		return kResultFalse;
-    if (!s.readDouble (triangleVolumeTwo))
-        return kResultFalse;
-	if (!s.readDouble (releaseTime))
-		return kResultFalse;
-	if (!s.readDouble(attackTime))
-		return kResultFalse;
-    if (!s.readDouble(sustainVolume))
-        return kResultFalse;
-    if (!s.readDouble(decayTime))
-        return kResultFalse;
-	if (!s.readDouble (sinusDetune))
-		return kResultFalse;
-    if (!s.readDouble (sinusDetuneTwo))
-        return kResultFalse;
-	if (!s.readDouble (triangleSlop))
-		return kResultFalse;
-    if (!s.readDouble (triangleSlopTwo))
-        return kResultFalse;
-	if (!s.readInt8 (bypassSNA))
+//-----------------------------------------------------------------------------
+tresult GlobalParameterState::setState (IBStream* stream)
+{
+	char tag[8];
+	int32 numRead = 0;
+	if (stream->read (tag, sizeof (tag), &numRead) != kResultTrue || numRead != sizeof (tag))
 		return kResultFalse;
 
-	if (version >= 1)
+	if (loadLittleEndian<uint32> (tag) != kStateMagic)
 	{
-        if (!s.readDouble (genFreqOne))
-            return kResultFalse;
-        if (!s.readDouble (genFreqTwo))
-            return kResultFalse;
-        if (!s.readDouble (stereoMs))
-            return kResultFalse;
-		if (!s.readInt8 (filterType))
-			return kResultFalse;
-		if (!s.readDouble (filterFreq))
-			return kResultFalse;
-		if (!s.readDouble (filterQ))
-			return kResultFalse;
-        if (!s.readInt8 (filterOneType))
-            return kResultFalse;
-        if (!s.readDouble (filterOneFreq))
-            return kResultFalse;
-        if (!s.readDouble (filterOneQ))
-            return kResultFalse;
-        if (!s.readInt8 (filterTwoType))
-            return kResultFalse;
-        if (!s.readDouble (filterTwoFreq))
-            return kResultFalse;
-        if (!s.readDouble (filterTwoQ))
-            return kResultFalse;
-        if (!s.readInt8 (oscType))
-            return kResultFalse;
-        if (!s.readInt8 (oscTypeTwo))
-            return kResultFalse;
-		if (!s.readDouble(freqModOn))
-			return kResultFalse;
-        if (!s.readDouble(saveState))
-            return kResultFalse;
-        if (!s.readDouble(loadState))
-            return kResultFalse;
-		if (!s.readDouble(filePath))
+		if (readFieldByField (*this, stream, loadLittleEndian<uint64> (tag)) != kResultTrue)
 			return kResultFalse;
 	}
-	if (version >= 2)
+	else
 	{
-		if (!s.readDouble (masterVolume))
-			return kResultFalse;
-		if (!s.readDouble (masterTuning))
-			return kResultFalse;
-		if (!s.readDouble (velToLevel))
+		uint32 version = loadLittleEndian<uint32> (tag + 4);
+		if (version > kStateVersion)
 			return kResultFalse;
-		if (!s.readDouble (freqModDepth))
+		// the rest of the header and the record in one read, checked before anything is applied
+		char buffer[kStateHeaderSize + kStateRecordSize];
+		char* header = buffer + sizeof (tag);
+		const char* record = buffer + kStateHeaderSize;
+		int32 size = (int32)(kStateHeaderSize - sizeof (tag) + stateRecordSize (version));
+		if (stream->read (header, size, &numRead) != kResultTrue || numRead != size)
 			return kResultFalse;
-		if (!s.readInt8 (tuningRange))
+		uint32 recordSize = loadLittleEndian<uint32> (header);
+		if (recordSize != stateRecordSize (version) ||
+		    loadLittleEndian<uint32> (header + 4) != stateChecksum (record, recordSize))
 			return kResultFalse;
+
+		for (const auto& desc : kParameterDescriptors)
+		{
+			if (desc.stateVersion == ParameterDescriptor::kNotStored || (uint32)desc.stateVersion > version)
+				continue;
+			if (desc.value)
+			{
+				this->*desc.value = loadLittleEndian<double> (record);
+				record += sizeof (double);
+			}
+			else
+				this->*desc.step = *record++;
+		}
 	}
-	if (version >= 3)
-	{
-		if (!s.readDouble (squareVolume))
-			return kResultFalse;
-        if (!s.readDouble (squareVolumeTwo))
-            return kResultFalse;
-	}
+	changedParameters = ~(uint64)0;
+	generation++;
 	return kResultTrue;
 }
 
 //-----------------------------------------------------------------------------
 tresult GlobalParameterState::getState (IBStream* stream)
 {
-	IBStreamer s (stream, kLittleEndian);
-
-	// version 0
-	if (!s.writeInt64u (currentParamStateVersion))
-		return kResultFalse;
-	if (!s.writeDouble (noiseVolume))
-		return kResultFalse;
-    if (!s.writeDouble (noiseVolumeTwo))
-        return kResultFalse;
-	if (!s.writeDouble (sinusVolume))
-		return kResultFalse;
-    if (!s.writeDouble (sinusVolumeTwo))
-        return kResultFalse;
-	if (!s.writeDouble (triangleVolume))
-		return kResultFalse;
-    if (!s.writeDouble (triangleVolumeTwo))
-        return kResultFalse;
-	if (!s.writeDouble (releaseTime))
-		return kResultFalse;
-	if (!s.writeDouble(attackTime))
-		return kResultFalse;
-    if (!s.writeDouble(sustainVolume))
-        return kResultFalse;
-    if (!s.writeDouble(decayTime))
-        return kResultFalse;
-	if (!s.writeDouble (sinusDetune))
-		return kResultFalse;
-    if (!s.writeDouble (sinusDetuneTwo))
-        return kResultFalse;
-	if (!s.writeDouble (triangleSlop))
-		return kResultFalse;
-    if (!s.writeDouble (triangleSlopTwo))
-        return kResultFalse;
-	if (!s.writeInt8 (bypassSNA))
-		return kResultFalse;
-
-	// version 1
-	if (!s.writeInt8 (filterType))
-		return kResultFalse;
-	if (!s.writeDouble (filterFreq))
-		return kResultFalse;
-	if (!s.writeDouble (filterQ))
-		return kResultFalse;
-    if (!s.writeInt8 (filterOneType))
-        return kResultFalse;
-    if (!s.writeDouble (filterOneFreq))
-        return kResultFalse;
-    if (!s.writeDouble (filterOneQ))
-        return kResultFalse;
-    if (!s.writeInt8 (filterTwoType))
-        return kResultFalse;
-    if (!s.writeDouble (filterTwoFreq))
-        return kResultFalse;
-    if (!s.writeDouble (filterTwoQ))
-        return kResultFalse;
-    if (!s.writeInt8 (oscType))
-        return kResultFalse;
-    if (!s.writeInt8 (oscTypeTwo))
-        return kResultFalse;
-	if (!s.writeDouble(freqModOn))
-		return kResultFalse;
-    if (!s.writeDouble(saveState))
-        return kResultFalse;
-    if (!s.writeDouble(loadState))
-        return kResultFalse;
-	if (!s.writeDouble(filePath))
-		return kResultFalse;
-
-	// version 2
-    if (!s.readDouble (genFreqOne))
-        return kResultFalse;
-    if (!s.readDouble (genFreqTwo))
-        return kResultFalse;
-    if (!s.readDouble (stereoMs))
-        return kResultFalse;
-	if (!s.writeDouble (masterVolume))
-		return kResultFalse;
-	if (!s.writeDouble (masterTuning))
-		return kResultFalse;
-	if (!s.writeDouble (velToLevel))
-		return kResultFalse;
-	if (!s.writeDouble (freqModDepth))
-		return kResultFalse;
-	if (!s.writeInt8 (tuningRange))
-		return kResultFalse;
+	char buffer[kStateHeaderSize + kStateRecordSize];
+	char* record = buffer + kStateHeaderSize;
+	char* field = record;
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (desc.stateVersion == ParameterDescriptor::kNotStored)
+			continue;
+		if (desc.value)
+		{
+			storeLittleEndian (field, this->*desc.value);
+			field += sizeof (double);
+		}
+		else
+			*field++ = this->*desc.step;
+	}
+	storeLittleEndian (buffer, kStateMagic);
+	storeLittleEndian (buffer + 4, kStateVersion);
+	storeLittleEndian (buffer + 8, kStateRecordSize);
+	storeLittleEndian (buffer + 12, stateChecksum (record, kStateRecordSize));
 
-	// version 3
-	if (!s.writeDouble (squareVolume))
+	int32 numWritten = 0;
+	if (stream->write (buffer, sizeof (buffer), &numWritten) != kResultTrue || numWritten != (int32)sizeof (buffer))
 		return kResultFalse;
-    if (!s.writeDouble (squareVolumeTwo))
-        return kResultFalse;
-
 	return kResultTrue;
 }
 
 //-----------------------------------------------------------------------------
-float VoiceStatics::freqTab[kNumFrequencies];
-const float VoiceStatics::scaleHeadRoom =
-    (float)(pow (10.0, -12.0 / 20.0) * 0.70710677); // for 12 dB head room
-const float VoiceStatics::scaleNorm2GainC1 =
-    (float)(VoiceStatics::scaleHeadRoom * pow (10.0, 24.0 / 20.0));
-const float VoiceStatics::scaleNorm2GainC2 =
-    (float)(24.0 / 20.0 / 0.30102999566398119521373889472449); // Mathd::kLog2
-LogScale<ParamValue> VoiceStatics::freqLogScale (0., 1., 80., 18000., 0.5, 1800.);
+// shared by every instance and the controller, so it is never changed after this
+LogScale<ParamValue> VoiceStatics::freqLogScale (0., 1., 10., 20000., 0.5, 447.213);
+LogScaleTable<ParamValue> VoiceStatics::freqLogTable;
 
 const double VoiceStatics::kNormTuningOneOctave = 12.0 / 240.0; // full in VST 3 is +- 10 octaves
 const double VoiceStatics::kNormTuningOneTune = 1.0 / 240.0;
+const double VoiceStatics::kGenFreqCenter = 261.; // middle C
+const double VoiceStatics::kMinGenFreq = 10.;
 
 //-----------------------------------------------------------------------------
 class VoiceStaticsOnce
@@ -262,17 +194,7 @@ class VoiceStaticsOnce
 public:
 	VoiceStaticsOnce ()
 	{
-		// make frequency (Hz) table
-		double k = 1.059463094359; // 12th root of 2
-		double a = 6.875; // a
-		a *= k; // b
-		a *= k; // bb
-		a *= k; // c, frequency of midi note 0
-		for (int32 i = 0; i < VoiceStatics::kNumFrequencies; i++) // 128 midi notes
-		{
-			VoiceStatics::freqTab[i] = (float)a;
-			a *= k;
-		}
+		VoiceStatics::freqLogTable.update (VoiceStatics::freqLogScale);
 	}
 };
 
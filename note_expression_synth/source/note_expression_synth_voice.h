@@ -40,12 +40,15 @@
 #include "../../common/logscale.h"
 #include "brownnoise.h"
 #include "filter.h"
+#include "fastmath.h"
+#include "voicetables.h"
+#include "tuning.h"
+#include "cpugovernor.h"
 #include "note_expression_synth_controller.h"
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/base/futils.h"
 #include <cmath>
 #include <algorithm>
-#include <queue>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -72,9 +75,6 @@ namespace NoteExpressionSynth {
 
 struct GlobalParameterState
 {
-	BrownNoise<float>* noiseBuffer;
-    BrownNoise<float>* noiseBufferTwo;
-    
 	ParamValue masterVolume;	// [0, +1]
 	ParamValue masterTuning;	// [-1, +1]
 	ParamValue velToLevel;		// [0, +1]
@@ -123,6 +123,11 @@ struct GlobalParameterState
     ParamValue saveState;       // [0, 1]
     ParamValue loadState;
 	ParamValue filePath;
+	ParamValue audibilityThreshold;	// [0, +1] of [MIN, MAX]_AUDIBILITY_THRESHOLD_DB
+	ParamValue polyphony;		// [0, +1] of [1, MAX_POLYPHONY], applied at setActive
+	ParamValue morph;			// [0, +1] from PresetMorph slot A to B
+	ParamValue morphStoreA;		// [0, 1]
+	ParamValue morphStoreB;
 	
 	int8 filterType;			// [0, 1, 2]
     int8 oscType;            // [0, 1, 2, 3]
@@ -132,9 +137,23 @@ struct GlobalParameterState
 	int8 tuningRange;			// [0, 1]
 	
 	int8 bypassSNA;				// [0, 1]
+	int8 renderThreads;			// [0, MAX_RENDER_THREADS], applied at setActive
+	int8 highPrecision;			// [0, 1] double instead of float voices, applied at setActive
+	int8 renderQuality;			// CpuGovernor::Level, set by the processor, not a parameter
+
+	const TuningTable* tuning;	// set by the processor every block, not a parameter
+
+	uint64 changedParameters;	// one bit per ParamID changed since the voices last rendered
+	uint32 generation;			// incremented on every change, voices compare it to skip work
 
+	static constexpr uint32 kStateVersion = 8;	// kParameterDescriptors::stateVersion of the newest fields
+
+	/** reads the checksummed state record or an older field by field stream */
 	tresult setState (IBStream* stream);
+	/** writes the state record of kStateVersion with one IBStream::write */
 	tresult getState (IBStream* stream);
+
+	int32 getNumVoices () const { return 1 + (int32)(polyphony * (MAX_POLYPHONY - 1) + 0.5); }
 };
 
 //-----------------------------------------------------------------------------
@@ -194,26 +213,27 @@ public:
 	//------------------------------------------------------------------------
 	static double normalizedLevel2Gain (float normalized)
 	{
-		double level;
-		if (normalized >= 0.5)
-			level = scaleHeadRoom * ::pow (10, (normalized - 0.5f) * 24 / 20.0f);
-		else
-			level = scaleNorm2GainC1 * ::pow (normalized, scaleNorm2GainC2);	
-
-		return level;
+		return VoiceTables::levelGain (normalized);
 	}	
 
 	enum {
-		kNumFrequencies = 128
+		kNumFrequencies = VoiceTables::kNumNotes
 	};
 
-	static float freqTab[kNumFrequencies];
-	static const float scaleHeadRoom;
-	static const float scaleNorm2GainC1;
-	static const float scaleNorm2GainC2;
 	static LogScale<ParamValue> freqLogScale;
+	static LogScaleTable<ParamValue> freqLogTable; // freqLogScale, built once at static initialization
 	static const double kNormTuningOneOctave;
 	static const double kNormTuningOneTune;
+	static const double kGenFreqCenter;		// Hz, the generator frequencies offset the note by freq - center
+	static const double kMinGenFreq;		// Hz
+
+	// the GlobalParameterState::changedParameters bits each group of derived voice values reads,
+	// the processor flags kParamMasterTuning for a new tuning table as well
+	static constexpr uint64 kFrequencyInputs = ((uint64)1 << kParamMasterTuning) | ((uint64)1 << kParamGenFreqOne) | ((uint64)1 << kParamGenFreqTwo);
+	static constexpr uint64 kFilterInputs = ((uint64)1 << kParamFilterFreq) | ((uint64)1 << kParamFilterQ) | ((uint64)1 << kParamFilterFreqModDepth) |
+	                                        ((uint64)1 << kParamFilterOneFreq) | ((uint64)1 << kParamFilterOneQ) | ((uint64)1 << kParamFilterOneFreqModDepth) |
+	                                        ((uint64)1 << kParamFilterTwoFreq) | ((uint64)1 << kParamFilterTwoQ) | ((uint64)1 << kParamFilterTwoFreqModDepth);
+	static constexpr uint64 kAudibilityInputs = (uint64)1 << kParamAudibilityThreshold;
 
 };
 
@@ -227,87 +247,161 @@ template<class SamplePrecision>
 class Voice : public VoiceBase<kNumParameters, SamplePrecision, 2, GlobalParameterState>
 {
 public:
+	typedef SamplePrecision Sample;
+
 	Voice ();
-	~Voice ();
 
 	void setSampleRate (ParamValue sampleRate) SMTG_OVERRIDE;
 	void noteOn (int32 pitch, ParamValue velocity, float tuning, int32 sampleOffset, int32 nId) SMTG_OVERRIDE;
 	void noteOff (ParamValue velocity, int32 sampleOffset) SMTG_OVERRIDE;
 	bool process (SamplePrecision* outputBuffers[2], int32 numSamples);
+	/** first half of process: generators, envelope and the CPU filters, safe on any thread */
+	bool render (int32 numSamples);
+	/** second half of process: the GPU filter and the output, on the thread owning Loadgl */
+	void mix (SamplePrecision* outputBuffers[2], int32 numSamples);
 	void reset () SMTG_OVERRIDE;
 
 	void setNoteExpressionValue (int32 index, ParamValue value) SMTG_OVERRIDE;
+	/** the voice only reads the state, VoiceBase just does not store it as const */
+	void setGlobalParameters (const GlobalParameterState* state) { this->globalParameters = const_cast<GlobalParameterState*> (state); }
 
-	ssbo_data mydata;
+	// for the CPU governor of the voice processor
+	bool isReleasing () const { return envelopeStage == kEnvelopeRelease; }
+	ParamValue getEnvelopeLevel () const { return currentVolume; }
+	/** ends the voice within seconds, faster than its release if necessary */
+	void fadeOut (ParamValue seconds);
 
-	double in1;
-	double in2;
-	double out1;
-	double out2;
-	bool firsttime = true;
+	enum { kMaxSamples = 1024 }; // same as ssbo_data
 
-	float dataA[1024];
-	float dataB[1024];
+	/** Sample buffers of one voice. They live outside the voice so the control state of all
+		voices stays dense, VoiceArena places them behind the voices. */
+	struct Buffers
+	{
+		ssbo_data mydata;		// uploaded to the GPU filter as a whole
+		SamplePrecision noiseBlock[kMaxSamples];
+		SamplePrecision noiseBlockTwo[kMaxSamples];
+		SamplePrecision envelopeBlock[kMaxSamples];
+	};
+
+	void setBuffers (Buffers* b) { buffers = b; }
 
 protected:
-	uint32 n;
-	int32 noisePos;
-    int32 noisePosTwo;
-	int32 noiseStep;
-    int32 noiseStepTwo;
-    bool decayStart = false;
+	enum EnvelopeStage
+	{
+		kEnvelopeAttack,
+		kEnvelopeDecay,		// decays to and then holds the sustain volume
+		kEnvelopeRelease,
+		kEnvelopeDone
+	};
 
-	Filter* filter;
-    Filter* filterOne;
-    Filter* filterTwo;
+	bool renderEnvelope (int32 numSamples);
+	void updateFrequencies ();
+	void updateFilterTargets ();
 
-	std::queue<SamplePrecision> delayQueue;
-	int current_ms = 0;
+	//---hot: read or written for every block and sample, kept together in declaration order
+	Buffers* buffers;
+	uint32 n;
+	EnvelopeStage envelopeStage;
+	bool rampsActive;
+	bool silentBlock;				// below audibleGain, render and mix skip the block
 
 	SamplePrecision trianglePhase;
 	SamplePrecision sinusPhase;
+	SamplePrecision trianglePhaseTwo;
+	SamplePrecision sinusPhaseTwo;
 	ParamValue currentTriangleF;
 	ParamValue currentSinusF;
-    SamplePrecision trianglePhaseTwo;
-    SamplePrecision sinusPhaseTwo;
-    ParamValue currentTriangleFTwo;
-    ParamValue currentSinusFTwo;
+	ParamValue currentTriangleFTwo;
+	ParamValue currentSinusFTwo;
+
 	ParamValue currentVolume;
+	ParamValue noteOnVolumeRamp;
+	ParamValue noteOnVolumeRampDecay;
+	ParamValue noteOffVolumeRamp;
+	ParamValue audibleGain;			// GlobalParameterState::audibilityThreshold as gain
 	ParamValue currentPanningLeft;
 	ParamValue currentPanningRight;
+	ParamValue panningLeftRamp;		// render to mix
+	ParamValue panningRightRamp;
+
 	ParamValue currentNoiseVolume;
 	ParamValue currentSinusVolume;
-	ParamValue currentSinusDetune;
 	ParamValue currentSquareVolume;
-    ParamValue currentNoiseVolumeTwo;
-    ParamValue currentSinusVolumeTwo;
-    ParamValue currentSinusDetuneTwo;
-    ParamValue currentSquareVolumeTwo;
-    ParamValue currentSustainVolume;
 	ParamValue currentTriangleVolume;
 	ParamValue currentTriangleSlope;
-    ParamValue currentTriangleVolumeTwo;
-    ParamValue currentTriangleSlopeTwo;
+	ParamValue currentNoiseVolumeTwo;
+	ParamValue currentSinusVolumeTwo;
+	ParamValue currentSquareVolumeTwo;
+	ParamValue currentTriangleVolumeTwo;
+	ParamValue currentTriangleSlopeTwo;
+
 	ParamValue currentLPFreq;
 	ParamValue currentLPQ;
-    ParamValue currentGenFreqOne;
-    ParamValue currentGenFreqTwo;
-	ParamValue currentFreqModOn;
-    ParamValue currentSaveState;
-    ParamValue currrentLoadState;
-    
-    ParamValue currentLPOneFreq;
-    ParamValue currentLPOneQ;
-    ParamValue currentLPTwoFreq;
-    ParamValue currentLPTwoQ;
-
+	ParamValue currentLPOneFreq;
+	ParamValue currentLPOneQ;
+	ParamValue currentLPTwoFreq;
+	ParamValue currentLPTwoQ;
+
+	Filter filter;
+	Filter filterOne;
+	Filter filterTwo;
+	BrownNoise<SamplePrecision> noise;
+	BrownNoise<SamplePrecision> noiseTwo;
+
+	//---cold: note on, parameter and note expression changes
+	// derived values are only recomputed when one of the generations moved
+	uint32 expressionGeneration;
+	uint32 derivedExpressionGeneration;
+	uint32 derivedGlobalGeneration;
+	ParamValue targetLPFreq;
+	ParamValue targetLPQ;
+	ParamValue targetLPOneFreq;
+	ParamValue targetLPOneQ;
+	ParamValue targetLPTwoFreq;
+	ParamValue targetLPTwoQ;
+	ParamValue currentSinusDetune;
+	ParamValue currentSinusDetuneTwo;
+	ParamValue currentSustainVolume;
 	ParamValue levelFromVel;
-	ParamValue noteOnVolumeRamp;
-	ParamValue noteOnVolumeRampDecay;
-	ParamValue noteOffVolumeRamp;
-    ParamValue stereoMs;
+	ParamValue stereoMs;
+
+	// state of the GPU filter pass
+	double in1;
+	double in2;
+	double out1;
+	double out2;
+	bool firsttime;
 };
 
+//-----------------------------------------------------------------------------
+/** ::sin, or FastMath::sin while the CPU governor asks for cheaper oscillators */
+inline double oscSin (double x, bool fast)
+{
+	return fast ? FastMath::sin (x) : ::sin (x);
+}
+
+//-----------------------------------------------------------------------------
+/** Returns the per sample step from current to target over rampTime samples.
+
+	Differences below kRampSnap are inaudible: current jumps to the target so the ramp ends
+	instead of creeping closer forever. active is set while any ramp is still running.
+*/
+static const ParamValue kRampSnap = 1e-7;
+
+inline ParamValue rampTo (ParamValue target, ParamValue& current, ParamValue rampTime, bool& active)
+{
+	ParamValue diff = target - current;
+	if (diff == 0.)
+		return 0.;
+	if (diff < kRampSnap && diff > -kRampSnap)
+	{
+		current = target;
+		return 0.;
+	}
+	active = true;
+	return diff / rampTime;
+}
+
 //-----------------------------------------------------------------------------
 template<class SamplePrecision>
 void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue value)
@@ -315,6 +409,8 @@ void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue val
 	if (this->globalParameters->bypassSNA)
 		return;
 
+	expressionGeneration++;
+
 	switch (index)
 	{
 		//------------------------------
@@ -439,7 +535,7 @@ void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue val
 		//------------------------------
 		case Controller::kFilterTypeTypeID:
 		{
-			filter->setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
+			filter.setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
 			break;
 		}
             
@@ -457,7 +553,7 @@ void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue val
             //------------------------------
         case Controller::kFilterOneTypeTypeID:
         {
-            filterOne->setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
+            filterOne.setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
             break;
         }
         case Controller::kGenFreqOneTypeID:
@@ -492,7 +588,7 @@ void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue val
             //------------------------------
         case Controller::kFilterTwoTypeTypeID:
         {
-            filterTwo->setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
+            filterTwo.setType ((Filter::Type)std::min<int32> ((int32)(NUM_FILTER_TYPE * value), NUM_FILTER_TYPE - 1));
             break;
         }
 		//------------------------------
@@ -573,24 +669,349 @@ void Voice<SamplePrecision>::setNoteExpressionValue (int32 index, ParamValue val
 template<class SamplePrecision>
 bool Voice<SamplePrecision>::process (SamplePrecision* outputBuffers[2], int32 numSamples)
 {
-	//---compute tuning-------------------------
-	//ssbo_CPUMEM.data[0] = temp;
-	//ssbo_CPUMEM.data[1] = temp2;
+	bool playing = render (numSamples);
+	mix (outputBuffers, numSamples);
+	return playing;
+}
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+bool Voice<SamplePrecision>::render (int32 numSamples)
+{
+	// pitch and filter targets only change with the note expressions or with the global
+	// parameters they read, a note expression feeds all of them
+	bool expressionChanged = derivedExpressionGeneration != expressionGeneration;
+	if (derivedGlobalGeneration != this->globalParameters->generation || expressionChanged)
+	{
+		uint64 changed = expressionChanged ? ~(uint64)0 : this->globalParameters->changedParameters;
+		derivedGlobalGeneration = this->globalParameters->generation;
+		derivedExpressionGeneration = expressionGeneration;
+		if (changed & VoiceStatics::kFrequencyInputs)
+			updateFrequencies ();
+		if (changed & VoiceStatics::kFilterInputs)
+			updateFilterTargets ();
+		if (changed & VoiceStatics::kAudibilityInputs)
+		{
+			ParamValue thresholdDB = MIN_AUDIBILITY_THRESHOLD_DB + this->globalParameters->audibilityThreshold * (MAX_AUDIBILITY_THRESHOLD_DB - MIN_AUDIBILITY_THRESHOLD_DB);
+			audibleGain = FastMath::exp2 (thresholdDB * FastMath::kLog2Of10 / 20.);
+		}
+		rampsActive = true;
+	}
+	ParamValue triangleFreq = currentTriangleF;
+	ParamValue triangleFreqTwo = currentTriangleFTwo;
+	ParamValue sinusFreq = currentSinusF;
+	ParamValue sinusFreqTwo = currentSinusFTwo;
+
+	//---calculate parameter ramps
+	panningLeftRamp = 0.;
+	panningRightRamp = 0.;
+	ParamValue noiseVolumeRamp = 0.;
+	ParamValue noiseVolumeRampTwo = 0.;
+	ParamValue sinusVolumeRamp = 0.;
+	ParamValue sinusVolumeRampTwo = 0.;
+	ParamValue triangleVolumeRamp = 0.;
+	ParamValue triangleVolumeRampTwo = 0.;
+	ParamValue squareVolumeRamp = 0.;
+	ParamValue squareVolumeRampTwo = 0.;
+	ParamValue filterFreqRamp = 0.;
+	ParamValue filterQRamp = 0.;
+	ParamValue filterOneFreqRamp = 0.;
+	ParamValue filterOneQRamp = 0.;
+	ParamValue filterTwoFreqRamp = 0.;
+	ParamValue filterTwoQRamp = 0.;
+	ParamValue triangleSlopeRamp = 0.;
+	ParamValue triangleSlopeRampTwo = 0.;
+
+	// in a steady sustain all ramps have settled and nothing is left to compute here
+	if (rampsActive)
+	{
+		ParamValue rampTime = std::max<ParamValue> ((ParamValue)numSamples, (this->sampleRate * 0.005));
+		rampsActive = false;
+
+		panningLeftRamp = rampTo (this->values[kPanningLeft], currentPanningLeft, rampTime, rampsActive);
+		panningRightRamp = rampTo (this->values[kPanningRight], currentPanningRight, rampTime, rampsActive);
+		noiseVolumeRamp = rampTo (this->values[kNoiseVolume], currentNoiseVolume, rampTime, rampsActive);
+		noiseVolumeRampTwo = rampTo (this->values[kNoiseVolumeTwo], currentNoiseVolumeTwo, rampTime, rampsActive);
+		sinusVolumeRamp = rampTo (this->values[kSinusVolume], currentSinusVolume, rampTime, rampsActive);
+		sinusVolumeRampTwo = rampTo (this->values[kSinusVolumeTwo], currentSinusVolumeTwo, rampTime, rampsActive);
+		squareVolumeRamp = rampTo (this->values[kSquareVolume], currentSquareVolume, rampTime, rampsActive);
+		squareVolumeRampTwo = rampTo (this->values[kSquareVolumeTwo], currentSquareVolumeTwo, rampTime, rampsActive);
+		triangleVolumeRamp = rampTo (this->values[kTriangleVolume], currentTriangleVolume, rampTime, rampsActive);
+		triangleVolumeRampTwo = rampTo (this->values[kTriangleVolumeTwo], currentTriangleVolumeTwo, rampTime, rampsActive);
+		triangleSlopeRamp = rampTo (this->values[kTriangleSlope], currentTriangleSlope, rampTime, rampsActive);
+		triangleSlopeRampTwo = rampTo (this->values[kTriangleSlopeTwo], currentTriangleSlopeTwo, rampTime, rampsActive);
+
+		filterFreqRamp = rampTo (targetLPFreq, currentLPFreq, rampTime, rampsActive);
+		filterQRamp = rampTo (targetLPQ, currentLPQ, rampTime, rampsActive);
+		filterOneFreqRamp = rampTo (targetLPOneFreq, currentLPOneFreq, rampTime, rampsActive);
+		filterOneQRamp = rampTo (targetLPOneQ, currentLPOneQ, rampTime, rampsActive);
+		filterTwoFreqRamp = rampTo (targetLPTwoFreq, currentLPTwoFreq, rampTime, rampsActive);
+		filterTwoQRamp = rampTo (targetLPTwoQ, currentLPTwoQ, rampTime, rampsActive);
+	}
+
+	// a release below the audibility threshold ends here instead of running down to zero
+	ParamValue panGain = std::max (std::max (currentPanningLeft, currentPanningRight),
+	                               std::max (this->values[kPanningLeft], this->values[kPanningRight]));
+	if (envelopeStage == kEnvelopeRelease && currentVolume * panGain < audibleGain)
+	{
+		currentVolume = 0.;
+		envelopeStage = kEnvelopeDone;
+	}
+
+	bool playing = renderEnvelope (numSamples);
+
+	// nothing to hear in this block: only keep the oscillators and ramps in time
+	ParamValue maxEnvelope = 0.;
+	for (int32 i = 0; i < numSamples; i++)
+		maxEnvelope = std::max<ParamValue> (maxEnvelope, buffers->envelopeBlock[i]);
+	silentBlock = maxEnvelope * panGain < audibleGain;
+	int32 numRenderSamples = silentBlock ? 0 : numSamples;
+	if (silentBlock)
+	{
+		n += numSamples;
+		currentLPFreq += filterFreqRamp * numSamples;
+		currentLPQ += filterQRamp * numSamples;
+		if (this->globalParameters->freqModOn >= .5)
+		{
+			currentLPOneFreq += filterOneFreqRamp * numSamples;
+			currentLPOneQ += filterOneQRamp * numSamples;
+			currentLPTwoFreq += filterTwoFreqRamp * numSamples;
+			currentLPTwoQ += filterTwoQRamp * numSamples;
+		}
+	}
+
+	// render the noise of this block up front, only for the generators that use it
+	if (this->globalParameters->oscType == 3 && !silentBlock)
+		noise.process (buffers->noiseBlock, numSamples);
+	if (this->globalParameters->oscTypeTwo == 3 && !silentBlock)
+		noiseTwo.process (buffers->noiseBlockTwo, numSamples);
+
+	// cheaper variants while the CPU governor is short of time
+	int8 quality = this->globalParameters->renderQuality;
+	int32 controlMask = quality >= CpuGovernor::kCoarseControlRate ? CpuGovernor::kCoarseControlInterval - 1 : 0;
+	bool fastOscillators = quality >= CpuGovernor::kFastOscillators;
+
+	for (int32 i = 0; i < numRenderSamples; i++)
+	{
+        //STOPPED SECOND GENERATOR HERE
+		SamplePrecision sample;
+        SamplePrecision sampleTwo;
+
+		if (this->globalParameters->freqModOn < .5 ) {
+			SamplePrecision oscTwo = (SamplePrecision)oscSin (n * triangleFreqTwo + trianglePhaseTwo, fastOscillators);
+			if (this->globalParameters->oscTypeTwo == 0)
+			{
+				sampleTwo = (SamplePrecision)(oscSin (n * sinusFreqTwo + sinusPhaseTwo, fastOscillators) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 1)
+			{
+				sampleTwo = (SamplePrecision)((::floor(oscTwo) + 0.5) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 2)
+			{
+				sampleTwo = (SamplePrecision)((oscTwo - ::fabs(oscSin (n * triangleFreqTwo + trianglePhaseTwo + 1 + currentTriangleSlopeTwo, fastOscillators))) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 3)
+			{
+				sampleTwo = (SamplePrecision)(buffers->noiseBlockTwo[i] * currentSinusVolumeTwo);
+			}
+
+			SamplePrecision osc = (SamplePrecision)oscSin (n * triangleFreq + trianglePhase + sampleTwo, fastOscillators);
+			if (this->globalParameters->oscType == 0)
+			{
+				sample = (SamplePrecision)(oscSin (n * sinusFreq + sinusPhase + sampleTwo, fastOscillators) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 1)
+			{
+				sample = (SamplePrecision)((::floor(osc) + 0.5) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 2)
+			{
+				sample = (SamplePrecision)((osc - ::fabs(oscSin (n * triangleFreq + trianglePhase + 1 + currentTriangleSlope, fastOscillators))) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 3)
+			{
+				sample = (SamplePrecision)(buffers->noiseBlock[i] * currentSinusVolume);
+			}
+		}
+		else {
+			SamplePrecision oscTwo = (SamplePrecision)oscSin (n * triangleFreqTwo + trianglePhaseTwo, fastOscillators);
+			if (this->globalParameters->oscTypeTwo == 0)
+			{
+				sampleTwo = (SamplePrecision)(oscSin (n * sinusFreqTwo + sinusPhaseTwo, fastOscillators) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 1)
+			{
+				sampleTwo = (SamplePrecision)((::floor(oscTwo) + 0.5) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 2)
+			{
+				sampleTwo = (SamplePrecision)((oscTwo - ::fabs(oscSin (n * triangleFreqTwo + trianglePhaseTwo + 1 + currentTriangleSlopeTwo, fastOscillators))) * currentSinusVolumeTwo);
+			}
+			else if (this->globalParameters->oscTypeTwo == 3)
+			{
+				sampleTwo = (SamplePrecision)(buffers->noiseBlockTwo[i] * currentSinusVolumeTwo);
+			}
+
+
+
+			//filter two
+			if (filterTwoFreqRamp != 0. || filterTwoQRamp != 0.)
+			{
+				if ((i & controlMask) == 0)
+					filterTwo.setFreqAndQ(VoiceStatics::freqLogTable.scale(currentLPTwoFreq), 1. - currentLPTwoQ);
+				currentLPTwoFreq += filterTwoFreqRamp;
+				currentLPTwoQ += filterTwoQRamp;
+			}
+			sampleTwo = (SamplePrecision)filterTwo.process(sampleTwo);
+
+
+			SamplePrecision osc = (SamplePrecision)oscSin (n * triangleFreq + trianglePhase, fastOscillators);
+			if (this->globalParameters->oscType == 0)
+			{
+				sample = (SamplePrecision)(oscSin (n * sinusFreq + sinusPhase, fastOscillators) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 1)
+			{
+				sample = (SamplePrecision)((::floor(osc) + 0.5) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 2)
+			{
+				sample = (SamplePrecision)((osc - ::fabs(oscSin (n * triangleFreq + trianglePhase + 1 + currentTriangleSlope, fastOscillators))) * currentSinusVolume);
+			}
+			else if (this->globalParameters->oscType == 3)
+			{
+				sample = (SamplePrecision)(buffers->noiseBlock[i] * currentSinusVolume);
+			}
+
+
+			//filter
+			if (filterOneFreqRamp != 0. || filterOneQRamp != 0.)
+			{
+				if ((i & controlMask) == 0)
+					filterOne.setFreqAndQ(VoiceStatics::freqLogTable.scale(currentLPOneFreq), 1. - currentLPOneQ);
+				currentLPOneFreq += filterOneFreqRamp;
+				currentLPOneQ += filterOneQRamp;
+			}
+			sample = (SamplePrecision)filterOne.process(sample);
+
+			//add together two samples after two filters
+			sample += sampleTwo;
+		}
+        
+        
+        
+		n++;
+		
+		// add noise
+		//sample += (SamplePrecision)(noiseBlock[i] * currentNoiseVolume);
+
+		// filter
+		if (filterFreqRamp != 0. || filterQRamp != 0.)
+		{
+			if ((i & controlMask) == 0)
+				filter.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPFreq), 1. - currentLPQ);
+			currentLPFreq += filterFreqRamp;
+			currentLPQ += filterQRamp;
+		}
+		//sample = (SamplePrecision)filter.process (sample);
+		in1 = buffers->mydata.dataB[numSamples - 1].x;
+		buffers->mydata.dataB[i].x = sample;
+		//in1 = 0;
+		
+	}
+
+	// coarse control rate: the last update may lie up to controlMask samples back
+	if (controlMask)
+	{
+		if (filterFreqRamp != 0. || filterQRamp != 0.)
+			filter.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPFreq), 1. - currentLPQ);
+		if (filterOneFreqRamp != 0. || filterOneQRamp != 0.)
+			filterOne.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPOneFreq), 1. - currentLPOneQ);
+		if (filterTwoFreqRamp != 0. || filterTwoQRamp != 0.)
+			filterTwo.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPTwoFreq), 1. - currentLPTwoQ);
+	}
+
+	// the volumes are constant within the block, move them to where the block ends
+	currentNoiseVolume += noiseVolumeRamp * numSamples;
+	currentNoiseVolumeTwo += noiseVolumeRampTwo * numSamples;
+	currentSinusVolume += sinusVolumeRamp * numSamples;
+	currentSinusVolumeTwo += sinusVolumeRampTwo * numSamples;
+	currentSquareVolume += squareVolumeRamp * numSamples;
+	currentSquareVolumeTwo += squareVolumeRampTwo * numSamples;
+	currentTriangleVolume += triangleVolumeRamp * numSamples;
+	currentTriangleVolumeTwo += triangleVolumeRampTwo * numSamples;
+	currentTriangleSlope += triangleSlopeRamp * numSamples;
+	currentTriangleSlopeTwo += triangleSlopeRampTwo * numSamples;
+
+	return playing;
+}
+
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void Voice<SamplePrecision>::mix (SamplePrecision* outputBuffers[2], int32 numSamples)
+{
+	if (silentBlock)
+	{
+		currentPanningLeft += panningLeftRamp * numSamples;
+		currentPanningRight += panningRightRamp * numSamples;
+		return;
+	}
+	if (firsttime) {
+		in1 = 0.0;
+		in2 = 0.0;
+		out1 = 0.0;
+		out2 = 0.0;
+		Loadgl::Instance()->setVars(numSamples, VoiceStatics::freqLogTable.scale(currentLPFreq), 1. - currentLPQ, this->globalParameters->filterType, this->sampleRate, in1, in2, out1, out2);
+		firsttime = false;
+	}
+	Loadgl::Instance()->setVars2(numSamples, VoiceStatics::freqLogTable.scale(currentLPFreq), 1. - currentLPQ, this->globalParameters->filterType, this->sampleRate);
+	Loadgl::Instance()->compute(&buffers->mydata);
+
+	for (int32 i = 0; i < numSamples; i++)
+	{
+
+		// store in output
+		outputBuffers[0][i] += (SamplePrecision)(buffers->mydata.dataB[i].x * currentPanningLeft * buffers->envelopeBlock[i]);
+		// dry, the stereo offset is applied once on the mix bus by the processor
+		outputBuffers[1][i] += (SamplePrecision)(buffers->mydata.dataB[i].x * currentPanningRight * buffers->envelopeBlock[i]);
+
+		buffers->mydata.dataB[i].x = 0;
+
+		// ramp parameters
+		currentPanningLeft += panningLeftRamp;
+		currentPanningRight += panningRightRamp;
+
+	}
+}
+
+//-----------------------------------------------------------------------------
+/** Oscillator frequencies from pitch, tuning, detune and the generator frequencies.
+
+	The note comes from the phase increment in GlobalParameterState::tuning, the offsets in Hz
+	on top of it are converted with its radiansPerHz. A changed frequency moves the phase so the
+	oscillator continues without a crackle.
+*/
+template<class SamplePrecision>
+void Voice<SamplePrecision>::updateFrequencies ()
+{
+	// the note itself is one table lookup, only the offsets on top of it are converted
+	const TuningTable* tuningTable = this->globalParameters->tuning;
+	ParamValue noteHz = tuningTable->frequencies[this->pitch];
+	ParamValue noteIncrement = tuningTable->increments[this->pitch];
+	ParamValue radiansPerHz = tuningTable->radiansPerHz;
+	ParamValue minIncrement = VoiceStatics::kMinGenFreq * radiansPerHz;
+
 	// main tuning
 	ParamValue tuningInHz = 0.;
 	if (this->values[kTuningMod] != 0. || this->globalParameters->masterTuning != 0 || this->tuning != 0)
 	{
-		tuningInHz = VoiceStatics::freqTab[this->pitch] * (::pow (2.0, (this->values[kTuningMod] * 10 + this->globalParameters->masterTuning * 2.0 / 12.0 + this->tuning)) - 1);
+		tuningInHz = noteHz * (FastMath::exp2 ((this->values[kTuningMod] * 10 + this->globalParameters->masterTuning * 2.0 / 12.0 + this->tuning)) - 1);
 	}
 	
     //Triangle one
-    double freqLogValOne = VoiceStatics::freqLogScale.scale(this->globalParameters->genFreqOne);
-    double genFreqOneHz =(VoiceStatics::freqTab[this->pitch] + tuningInHz + freqLogValOne - 261);
-    if (genFreqOneHz < 10)
-    {
-        genFreqOneHz = 10;
-    }
-	ParamValue triangleFreq = genFreqOneHz * M_PI_MUL_2 / this->getSampleRate () / 2.;
+    double offsetOneHz = tuningInHz + VoiceStatics::freqLogTable.scale (this->globalParameters->genFreqOne) - VoiceStatics::kGenFreqCenter;
+	ParamValue triangleFreq = std::max (noteIncrement + offsetOneHz * radiansPerHz, minIncrement) / 2.;
 	if (currentTriangleF == -1)
 		currentTriangleF = triangleFreq;
 	// check for frequency changes and update the phase so that it is crackle free
@@ -602,13 +1023,8 @@ bool Voice<SamplePrecision>::process (SamplePrecision* outputBuffers[2], int32 n
 	}
     
     //triangle two
-    double freqLogValTwo = VoiceStatics::freqLogScale.scale(this->globalParameters->genFreqTwo);
-    double genFreqTwoHz =(VoiceStatics::freqTab[this->pitch] + tuningInHz + freqLogValTwo - 261);
-    if (genFreqTwoHz < 10)
-    {
-        genFreqTwoHz = 10;
-    }
-    ParamValue triangleFreqTwo = genFreqTwoHz * M_PI_MUL_2 / this->getSampleRate () / 2.;
+    double offsetTwoHz = tuningInHz + VoiceStatics::freqLogTable.scale (this->globalParameters->genFreqTwo) - VoiceStatics::kGenFreqCenter;
+    ParamValue triangleFreqTwo = std::max (noteIncrement + offsetTwoHz * radiansPerHz, minIncrement) / 2.;
     if (currentTriangleFTwo == -1)
         currentTriangleFTwo = triangleFreqTwo;
     // check for frequency changes and update the phase so that it is crackle free
@@ -622,15 +1038,9 @@ bool Voice<SamplePrecision>::process (SamplePrecision* outputBuffers[2], int32 n
 	// Sinus Detune one
 	if (currentSinusDetune != this->values[kSinusDetune])
 	{
-		currentSinusDetune = VoiceStatics::freqTab[this->pitch] * (::pow (2.0, this->values[kSinusDetune] * 2.0 / 12.0) - 1);
+		currentSinusDetune = noteHz * (FastMath::exp2 (this->values[kSinusDetune] * 2.0 / 12.0) - 1);
 	}
-    freqLogValOne = VoiceStatics::freqLogScale.scale(this->globalParameters->genFreqOne);
-    genFreqOneHz =(VoiceStatics::freqTab[this->pitch] + tuningInHz + currentSinusDetune + freqLogValOne - 261);//middleC
-    if (genFreqOneHz < 10)
-    {
-        genFreqOneHz = 10;
-    }
-    ParamValue sinusFreq = (genFreqOneHz) * M_PI_MUL_2 / this->getSampleRate ();
+    ParamValue sinusFreq = std::max (noteIncrement + (offsetOneHz + currentSinusDetune) * radiansPerHz, minIncrement);
     
 	if (currentSinusF == -1)
 		currentSinusF = sinusFreq;
@@ -644,15 +1054,9 @@ bool Voice<SamplePrecision>::process (SamplePrecision* outputBuffers[2], int32 n
     // Sinus Detune two
     if (currentSinusDetuneTwo != this->values[kSinusDetuneTwo])
     {
-        currentSinusDetuneTwo = VoiceStatics::freqTab[this->pitch] * (::pow (2.0, this->values[kSinusDetuneTwo] * 2.0 / 12.0) - 1);
-    }
-    freqLogValTwo = VoiceStatics::freqLogScale.scale(this->globalParameters->genFreqTwo);
-    genFreqTwoHz = (VoiceStatics::freqTab[this->pitch] + tuningInHz + currentSinusDetuneTwo +  freqLogValTwo - 261);//middleC
-    if (genFreqTwoHz < 10)
-    {
-        genFreqTwoHz = 10;
+        currentSinusDetuneTwo = noteHz * (FastMath::exp2 (this->values[kSinusDetuneTwo] * 2.0 / 12.0) - 1);
     }
-    ParamValue sinusFreqTwo = (genFreqTwoHz) * M_PI_MUL_2 / this->getSampleRate ();
+    ParamValue sinusFreqTwo = std::max (noteIncrement + (offsetTwoHz + currentSinusDetuneTwo) * radiansPerHz, minIncrement);
     
     if (currentSinusFTwo == -1)
         currentSinusFTwo = sinusFreqTwo;
@@ -662,392 +1066,103 @@ bool Voice<SamplePrecision>::process (SamplePrecision* outputBuffers[2], int32 n
         sinusPhaseTwo = (SamplePrecision)((currentSinusFTwo - sinusFreqTwo) * n) + sinusPhaseTwo;
         currentSinusFTwo = sinusFreqTwo;
     }
-    
-	//---calculate parameter ramps
-	ParamValue volumeRamp = 0.;
-	ParamValue panningLeftRamp = 0.;
-	ParamValue panningRightRamp = 0.;
-	ParamValue noiseVolumeRamp = 0.;
-    ParamValue noiseVolumeRampTwo = 0.;
-	ParamValue sinusVolumeRamp = 0.;
-    ParamValue sinusVolumeRampTwo = 0.;
-	ParamValue triangleVolumeRamp = 0.;
-    ParamValue triangleVolumeRampTwo = 0.;
-	ParamValue squareVolumeRamp = 0.;
-    ParamValue squareVolumeRampTwo = 0.;
-	ParamValue filterFreqRamp = 0.;
-    ParamValue genFreqRampOne = 0.;
-    ParamValue genFreqRampTwo = 0.;
-	ParamValue filterQRamp = 0.;
-    ParamValue filterOneFreqRamp = 0.;
-    ParamValue filterOneQRamp = 0.;
-    ParamValue filterTwoFreqRamp = 0.;
-    ParamValue filterTwoQRamp = 0.;
-	ParamValue triangleSlopeRamp = 0.;
-    ParamValue triangleSlopeRampTwo = 0.;
-    // ParamValue stereoRamp = 0.;
-	ParamValue rampTime = std::max<ParamValue> ((ParamValue)numSamples, (this->sampleRate * 0.005));
-	
-	ParamValue wantedVolume = VoiceStatics::normalizedLevel2Gain ((float)Bound (0.0, 1.0, this->globalParameters->masterVolume * levelFromVel + this->values[kVolumeMod]));
-	if (wantedVolume != currentVolume)
-	{
-		volumeRamp = (wantedVolume - currentVolume) / rampTime;
-	}
+}
 
-	if (this->values[kPanningLeft] != currentPanningLeft)
-	{
-		panningLeftRamp = (this->values[kPanningLeft] - currentPanningLeft) / rampTime;
-	}
-	if (this->values[kPanningRight] != currentPanningRight)
-	{
-		panningRightRamp = (this->values[kPanningRight] - currentPanningRight) / rampTime;
-	}
-	if (this->values[kNoiseVolume] != currentNoiseVolume)
-	{
-		noiseVolumeRamp = (this->values[kNoiseVolume] - currentNoiseVolume) / rampTime;
-	}
-    if (this->values[kNoiseVolumeTwo] != currentNoiseVolumeTwo)
-    {
-        noiseVolumeRampTwo = (this->values[kNoiseVolumeTwo] - currentNoiseVolumeTwo) / rampTime;
-    }
-	if (this->values[kSinusVolume] != currentSinusVolume)
-	{
-		sinusVolumeRamp = (this->values[kSinusVolume] - currentSinusVolume) / rampTime;
-	}
-    if (this->values[kSinusVolumeTwo] != currentSinusVolumeTwo)
-    {
-        sinusVolumeRampTwo = (this->values[kSinusVolumeTwo] - currentSinusVolumeTwo) / rampTime;
-    }
-	if (this->values[kSquareVolume] != currentSquareVolume)
-	{
-		squareVolumeRamp = (this->values[kSquareVolume] - currentSquareVolume) / rampTime;
-	}
-    if (this->values[kSquareVolumeTwo] != currentSquareVolumeTwo)
-    {
-        squareVolumeRampTwo = (this->values[kSquareVolumeTwo] - currentSquareVolumeTwo) / rampTime;
-    }
-	if (this->values[kTriangleVolume] != currentTriangleVolume)
-	{
-		triangleVolumeRamp = (this->values[kTriangleVolume] - currentTriangleVolume) / rampTime;
-	}
-    if (this->values[kTriangleVolumeTwo] != currentTriangleVolumeTwo)
-    {
-        triangleVolumeRampTwo = (this->values[kTriangleVolumeTwo] - currentTriangleVolumeTwo) / rampTime;
-    }
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void Voice<SamplePrecision>::updateFilterTargets ()
+{
+	targetLPFreq = Bound (0., 1., this->globalParameters->filterFreq + this->globalParameters->freqModDepth * this->values[kFilterFrequencyMod]);
+	targetLPQ = Bound (0., 1., this->globalParameters->filterQ + this->values[kFilterQMod]);
+	targetLPOneFreq = Bound (0., 1., this->globalParameters->filterOneFreq + this->globalParameters->freqOneModDepth * this->values[kFilterOneFrequencyMod]);
+	targetLPOneQ = Bound (0., 1., this->globalParameters->filterOneQ + this->values[kFilterOneQMod]);
+	targetLPTwoFreq = Bound (0., 1., this->globalParameters->filterTwoFreq + this->globalParameters->freqTwoModDepth * this->values[kFilterTwoFrequencyMod]);
+	targetLPTwoQ = Bound (0., 1., this->globalParameters->filterTwoQ + this->values[kFilterTwoQMod]);
+}
 
-    
-//    ParamValue wantedGenFreqOne = Bound (0., 1., this->globalParameters->filterFreq + this->globalParameters->freqModDepth * this->values[kFilterFrequencyMod]);
-//    if (wantedGenFreqOne != currentGenFreqOne)
-//    {
-//        genFreqRampOne = (wantedGenFreqOne - currentGenFreqOne) / rampTime;
-//    }
-//    ParamValue wantedGenFreqTwo = Bound (0., 1., this->globalParameters->filterFreq + this->globalParameters->freqModDepth * this->values[kFilterFrequencyMod]);
-//    if (wantedGenFreqTwo != currentGenFreqTwo)
-//    {
-//        genFreqRampTwo = (wantedGenFreqTwo - currentGenFreqTwo) / rampTime;
-//    }
-    
-	ParamValue wantedLPFreq = Bound (0., 1., this->globalParameters->filterFreq + this->globalParameters->freqModDepth * this->values[kFilterFrequencyMod]);
-	if (wantedLPFreq != currentLPFreq)
-	{
-		filterFreqRamp = (wantedLPFreq - currentLPFreq) / rampTime;
-	}
-	ParamValue wantedLPQ = Bound (0., 1., this->globalParameters->filterQ + this->values[kFilterQMod]);
-	if (wantedLPQ != currentLPQ)
-	{
-		filterQRamp = (wantedLPQ - currentLPQ) / rampTime;
-	}
-    //_____________new filters______________________
-    ParamValue wantedLPOneFreq = Bound (0., 1., this->globalParameters->filterOneFreq + this->globalParameters->freqOneModDepth * this->values[kFilterOneFrequencyMod]);
-    if (wantedLPOneFreq != currentLPOneFreq)
-    {
-        filterOneFreqRamp = (wantedLPOneFreq - currentLPOneFreq) / rampTime;
-    }
-    ParamValue wantedLPOneQ = Bound (0., 1., this->globalParameters->filterOneQ + this->values[kFilterOneQMod]);
-    if (wantedLPOneQ != currentLPOneQ)
-    {
-        filterOneQRamp = (wantedLPOneQ - currentLPOneQ) / rampTime;
-    }
-    ParamValue wantedLPTwoFreq = Bound (0., 1., this->globalParameters->filterTwoFreq + this->globalParameters->freqTwoModDepth * this->values[kFilterTwoFrequencyMod]);
-    if (wantedLPTwoFreq != currentLPTwoFreq)
-    {
-        filterTwoFreqRamp = (wantedLPTwoFreq - currentLPTwoFreq) / rampTime;
-    }
-    ParamValue wantedLPTwoQ = Bound (0., 1., this->globalParameters->filterTwoQ + this->values[kFilterTwoQMod]);
-    if (wantedLPTwoQ != currentLPTwoQ)
-    {
-        filterTwoQRamp = (wantedLPTwoQ - currentLPTwoQ) / rampTime;
-    }
-    //____________end new filters ____________
-	if (this->values[kTriangleSlope] != currentTriangleSlope)
-	{
-		triangleSlopeRamp = (this->values[kTriangleSlope] - currentTriangleSlope) / rampTime;
-	}
-    if (this->values[kTriangleSlopeTwo] != currentTriangleSlopeTwo)
-    {
-        triangleSlopeRampTwo = (this->values[kTriangleSlopeTwo] - currentTriangleSlopeTwo) / rampTime;
-    }
+//-----------------------------------------------------------------------------
+/** Fills envelopeBlock with the per sample envelope gain.
 
-	for (int32 i = 0; i < numSamples; i++)
+	The block is cut where the envelope changes stage, each piece is a plain linear ramp.
+	Returns false once the release has reached zero.
+*/
+template<class SamplePrecision>
+bool Voice<SamplePrecision>::renderEnvelope (int32 numSamples)
+{
+	int32 pos = 0;
+	while (pos < numSamples)
 	{
-		this->noteOnSampleOffset--;
-		this->noteOffSampleOffset--;
-
-        if (this->noteOffSampleOffset < 0)
-        {
-            volumeRamp = 0;
-            if (decayStart)
-            {
-                //turn decayStart off in release below
-                currentVolume -= noteOnVolumeRampDecay;
-                if (currentVolume <= (this->globalParameters->sustainVolume))
-                {
-                    currentVolume = (this->globalParameters->sustainVolume);
-                }
-            }
-            
-            //COME BACK WITH MAX VOLUME .8
-            else if (currentVolume < MAX_VOLUME)
-            {
-                // ramp note on
-                currentVolume += noteOnVolumeRamp;
-                if (currentVolume > MAX_VOLUME)
-                {
-                    currentVolume = MAX_VOLUME;
-                    decayStart = true;
-                }
-            }
-            else
-            {
-                this->noteOnSampleOffset = -1;
-            }
-            
-        }
-		if (this->noteOnSampleOffset <= 0)
+		int32 count = numSamples - pos;
+		ParamValue ramp = 0.;
+		ParamValue target = currentVolume;
+		switch (envelopeStage)
 		{
-			// we are in Release
-			if (this->noteOffSampleOffset == 0)
+			case kEnvelopeAttack:
 			{
- 				volumeRamp = 0;
-				if (currentVolume > 0)
-				{
-					// ramp note off
-					currentVolume -= noteOffVolumeRamp;
-					if (currentVolume < 0.)
-						currentVolume = 0.;
-					this->noteOffSampleOffset++;
-				}
-				else
-				{
-					this->noteOffSampleOffset = this->noteOnSampleOffset = -1;
-                    decayStart = false;
-					return false;
-				}
+				ramp = noteOnVolumeRamp;
+				target = MAX_VOLUME;
+				break;
 			}
-            //STOPPED SECOND GENERATOR HERE
-			SamplePrecision sample;
-            SamplePrecision sampleTwo;
-
-			if (this->globalParameters->freqModOn < .5 ) {
-				SamplePrecision oscTwo = (SamplePrecision)sin(n * triangleFreqTwo + trianglePhaseTwo);
-				if (this->globalParameters->oscTypeTwo == 0)
-				{
-					sampleTwo = (SamplePrecision)(sin(n * sinusFreqTwo + sinusPhaseTwo) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 1)
-				{
-					sampleTwo = (SamplePrecision)((::floor(oscTwo) + 0.5) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 2)
-				{
-					sampleTwo = (SamplePrecision)((oscTwo - ::fabs(sin(n * triangleFreqTwo + trianglePhaseTwo + 1 + currentTriangleSlopeTwo))) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 3)
-				{
-					sampleTwo = (SamplePrecision)(this->globalParameters->noiseBufferTwo->at(noisePosTwo) * currentSinusVolumeTwo);
-				}
-
-				SamplePrecision osc = (SamplePrecision)sin(n * triangleFreq + trianglePhase + sampleTwo);
-				if (this->globalParameters->oscType == 0)
-				{
-					sample = (SamplePrecision)(sin(n * sinusFreq + sinusPhase + sampleTwo) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 1)
-				{
-					sample = (SamplePrecision)((::floor(osc) + 0.5) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 2)
-				{
-					sample = (SamplePrecision)((osc - ::fabs(sin(n * triangleFreq + trianglePhase + 1 + currentTriangleSlope))) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 3)
+			case kEnvelopeDecay:
+			{
+				ParamValue sustain = this->globalParameters->sustainVolume;
+				if (currentVolume > sustain)
 				{
-					sample = (SamplePrecision)(this->globalParameters->noiseBuffer->at(noisePos) * currentSinusVolume);
+					ramp = -noteOnVolumeRampDecay;
+					target = sustain;
 				}
+				else
+					currentVolume = sustain;
+				break;
 			}
-			else {
-				SamplePrecision oscTwo = (SamplePrecision)sin(n * triangleFreqTwo + trianglePhaseTwo);
-				if (this->globalParameters->oscTypeTwo == 0)
-				{
-					sampleTwo = (SamplePrecision)(sin(n * sinusFreqTwo + sinusPhaseTwo) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 1)
-				{
-					sampleTwo = (SamplePrecision)((::floor(oscTwo) + 0.5) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 2)
-				{
-					sampleTwo = (SamplePrecision)((oscTwo - ::fabs(sin(n * triangleFreqTwo + trianglePhaseTwo + 1 + currentTriangleSlopeTwo))) * currentSinusVolumeTwo);
-				}
-				else if (this->globalParameters->oscTypeTwo == 3)
-				{
-					sampleTwo = (SamplePrecision)(this->globalParameters->noiseBufferTwo->at(noisePosTwo) * currentSinusVolumeTwo);
-				}
-
-
-
-				//filter two
-				if (filterTwoFreqRamp != 0. || filterTwoQRamp != 0.)
-				{
-					filterTwo->setFreqAndQ(VoiceStatics::freqLogScale.scale(currentLPTwoFreq), 1. - currentLPTwoQ);
-					currentLPTwoFreq += filterTwoFreqRamp;
-					currentLPTwoQ += filterTwoQRamp;
-				}
-				sampleTwo = (SamplePrecision)filterTwo->process(sampleTwo);
-
-
-				SamplePrecision osc = (SamplePrecision)sin(n * triangleFreq + trianglePhase);
-				if (this->globalParameters->oscType == 0)
-				{
-					sample = (SamplePrecision)(sin(n * sinusFreq + sinusPhase) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 1)
-				{
-					sample = (SamplePrecision)((::floor(osc) + 0.5) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 2)
-				{
-					sample = (SamplePrecision)((osc - ::fabs(sin(n * triangleFreq + trianglePhase + 1 + currentTriangleSlope))) * currentSinusVolume);
-				}
-				else if (this->globalParameters->oscType == 3)
-				{
-					sample = (SamplePrecision)(this->globalParameters->noiseBuffer->at(noisePos) * currentSinusVolume);
-				}
-
-
-				//filter
-				if (filterOneFreqRamp != 0. || filterOneQRamp != 0.)
+			case kEnvelopeRelease:
+			{
+				ramp = -noteOffVolumeRamp;
+				target = 0.;
+				if (currentVolume <= 0. || ramp >= 0.)
 				{
-					filterOne->setFreqAndQ(VoiceStatics::freqLogScale.scale(currentLPOneFreq), 1. - currentLPOneQ);
-					currentLPOneFreq += filterOneFreqRamp;
-					currentLPOneQ += filterOneQRamp;
+					currentVolume = 0.;
+					envelopeStage = kEnvelopeDone;
+					continue;
 				}
-				sample = (SamplePrecision)filterOne->process(sample);
-
-				//add together two samples after two filters
-				sample += sampleTwo;
+				break;
 			}
-            
-            
-            
-			n++;
-			
-			// add noise
-			//sample += (SamplePrecision)(this->globalParameters->noiseBuffer->at (noisePos) * currentNoiseVolume);
-
-			// filter
-			if (filterFreqRamp != 0. || filterQRamp != 0.)
+			case kEnvelopeDone:
 			{
-				filter->setFreqAndQ (VoiceStatics::freqLogScale.scale (currentLPFreq), 1. - currentLPQ);
-				currentLPFreq += filterFreqRamp;
-				currentLPQ += filterQRamp;
+				for (int32 i = pos; i < numSamples; i++)
+					buffers->envelopeBlock[i] = 0;
+				return false;
 			}
-			//sample = (SamplePrecision)filter->process (sample);
-			in1 = mydata.dataB[numSamples - 1].x;
-			mydata.dataB[i].x = sample;
-			//in1 = 0;
-			
 		}
-	}
-	if (firsttime) {
-		in1 = 0.0;
-		in2 = 0.0;
-		out1 = 0.0;
-		out2 = 0.0;
-		Loadgl::Instance()->setVars(numSamples, VoiceStatics::freqLogScale.scale(currentLPFreq), 1. - currentLPQ, this->globalParameters->filterType, this->sampleRate, in1, in2, out1, out2);
-		firsttime = false;
-	}
-	Loadgl::Instance()->setVars2(numSamples, VoiceStatics::freqLogScale.scale(currentLPFreq), 1. - currentLPQ, this->globalParameters->filterType, this->sampleRate);
-	Loadgl::Instance()->compute(&mydata);
-
-	for (int32 i = 0; i < numSamples; i++)
-	{
-
-		// store in output
-		outputBuffers[0][i] += (SamplePrecision)(mydata.dataB[i].x * currentPanningLeft * currentVolume);
-
-		//STEREO
-
-		//Change in Delay
-		if (Voice::current_ms != int(300 * this->globalParameters->stereoMs)) {
-			Voice::current_ms = int(300 * this->globalParameters->stereoMs);
-			while (!Voice::delayQueue.empty()) {
-				Voice::delayQueue.pop();
-			}
-			for (int i = 0; i < 44100 * (300 * this->globalParameters->stereoMs / 1000.00); i++) {
-				Voice::delayQueue.push((SamplePrecision)0);
-			}
-		}
-
-		Voice::delayQueue.push((SamplePrecision)(mydata.dataB[i].x * currentPanningRight * currentVolume));
 
-		outputBuffers[1][i] += Voice::delayQueue.front();
-		Voice::delayQueue.pop();
-
-		mydata.dataB[i].x = 0;
-
-		// advance noise
-		noisePos += noiseStep;
-		if (noisePos > this->globalParameters->noiseBuffer->getSize() - 2)
+		bool stageEnds = false;
+		if (ramp != 0.)
 		{
-			noisePos = (int32)((float)::rand() / (float)RAND_MAX * (this->globalParameters->noiseBuffer->getSize() - 2) + 2);
-			noiseStep = -1;
-		}
-		else if (noisePos < 2)
-		{
-			noiseStep = 1;
+			ParamValue toTarget = ::ceil ((target - currentVolume) / ramp);
+			if (toTarget <= count)
+			{
+				count = std::max<int32> ((int32)toTarget, 0);
+				stageEnds = true;
+			}
 		}
-
-		// advance noise
-		noisePosTwo += noiseStepTwo;
-		if (noisePosTwo > this->globalParameters->noiseBufferTwo->getSize() - 2)
+		for (int32 i = 0; i < count; i++)
 		{
-			noisePosTwo = (int32)((float)::rand() / (float)RAND_MAX * (this->globalParameters->noiseBufferTwo->getSize() - 2) + 2);
-			noiseStepTwo = -1;
+			currentVolume += ramp;
+			buffers->envelopeBlock[pos + i] = (SamplePrecision)currentVolume;
 		}
-		else if (noisePosTwo < 2)
+		if (stageEnds)
 		{
-			noiseStepTwo = 1;
+			currentVolume = target;
+			if (count > 0)
+				buffers->envelopeBlock[pos + count - 1] = (SamplePrecision)target;
+			if (envelopeStage == kEnvelopeAttack)
+				envelopeStage = kEnvelopeDecay;
+			else if (envelopeStage == kEnvelopeRelease)
+				envelopeStage = kEnvelopeDone;
 		}
-
-		// ramp parameters
-		currentVolume += volumeRamp;
-		currentPanningLeft += panningLeftRamp;
-		currentPanningRight += panningRightRamp;
-		currentNoiseVolume += noiseVolumeRamp;
-		currentNoiseVolumeTwo += noiseVolumeRampTwo;
-		currentSinusVolume += sinusVolumeRamp;
-		currentSinusVolumeTwo += sinusVolumeRampTwo;
-		currentSquareVolume += squareVolumeRamp;
-		currentSquareVolumeTwo += squareVolumeRampTwo;
-		currentTriangleVolume += triangleVolumeRamp;
-		currentTriangleVolumeTwo += triangleVolumeRampTwo;
-		currentTriangleSlope += triangleSlopeRamp;
-		currentTriangleSlopeTwo += triangleSlopeRampTwo;
-
+		pos += count;
 	}
-
-	return true;
+	return envelopeStage != kEnvelopeDone;
 }
 
     
@@ -1079,8 +1194,8 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
 	currentLPQ =  this->globalParameters->filterQ;
 	this->values[kFilterQMod] = 0;
 
-	filter->setType ((Filter::Type)this->globalParameters->filterType);
-	filter->setFreqAndQ (VoiceStatics::freqLogScale.scale (currentLPFreq), 1. - currentLPQ);
+	filter.setType ((Filter::Type)this->globalParameters->filterType);
+	filter.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPFreq), 1. - currentLPQ);
     
     // filter One setting
     currentLPOneFreq = this->globalParameters->filterOneFreq;
@@ -1088,8 +1203,8 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
     currentLPOneQ =  this->globalParameters->filterOneQ;
     this->values[kFilterOneQMod] = 0;
     
-    filterOne->setType ((Filter::Type)this->globalParameters->filterOneType);
-    filterOne->setFreqAndQ (VoiceStatics::freqLogScale.scale (currentLPOneFreq), 1. - currentLPOneQ);
+    filterOne.setType ((Filter::Type)this->globalParameters->filterOneType);
+    filterOne.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPOneFreq), 1. - currentLPOneQ);
     
     // filter Two setting
     currentLPTwoFreq = this->globalParameters->filterTwoFreq;
@@ -1097,13 +1212,13 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
     currentLPTwoQ =  this->globalParameters->filterTwoQ;
     this->values[kFilterTwoQMod] = 0;
     
-    filterTwo->setType ((Filter::Type)this->globalParameters->filterTwoType);
-    filterTwo->setFreqAndQ (VoiceStatics::freqLogScale.scale (currentLPTwoFreq), 1. - currentLPTwoQ);
+    filterTwo.setType ((Filter::Type)this->globalParameters->filterTwoType);
+    filterTwo.setFreqAndQ (VoiceStatics::freqLogTable.scale (currentLPTwoFreq), 1. - currentLPTwoQ);
 
 	currentSinusDetune = 0.;
 	if (this->globalParameters->sinusDetune != 0.)
 	{
-		currentSinusDetune = VoiceStatics::freqTab[this->pitch] * (::pow (2.0, this->globalParameters->sinusDetune * 2.0 / 12.0) - 1);
+		currentSinusDetune = this->globalParameters->tuning->frequencies[this->pitch] * (FastMath::exp2 (this->globalParameters->sinusDetune * 2.0 / 12.0) - 1);
 	}
 	this->values[kSinusDetune] = currentSinusDetune;
 	this->values[kTuningMod] = 0;
@@ -1112,7 +1227,7 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
     currentSinusDetuneTwo = 0.;
     if (this->globalParameters->sinusDetuneTwo != 0.)
     {
-        currentSinusDetuneTwo = VoiceStatics::freqTab[this->pitch] * (::pow (2.0, this->globalParameters->sinusDetuneTwo * 2.0 / 12.0) - 1);
+        currentSinusDetuneTwo = this->globalParameters->tuning->frequencies[this->pitch] * (FastMath::exp2 (this->globalParameters->sinusDetuneTwo * 2.0 / 12.0) - 1);
     }
     this->values[kSinusDetuneTwo] = currentSinusDetuneTwo;
     this->values[kTuningMod] = 0; //DO I NEED 2???
@@ -1125,7 +1240,7 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
         if (this->values[kAttackTimeMod] == 0)
             timeFactor = 1;
         else
-            timeFactor = ::pow (100., this->values[kAttackTimeMod]);
+            timeFactor = VoiceTables::timeFactor (this->values[kAttackTimeMod]);
         
         noteOnVolumeRamp = 1.0 / (timeFactor * this->sampleRate * ((this->globalParameters->attackTime * MAX_ATTACK_TIME_SEC) + 0.005));
         if (currentVolume)
@@ -1137,7 +1252,7 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
         if (this->values[kDecayTimeMod] == 0)
             timeFactorDecay = 1;
         else
-            timeFactorDecay = ::pow (100., this->values[kDecayTimeMod]);
+            timeFactorDecay = VoiceTables::timeFactor (this->values[kDecayTimeMod]);
         
         noteOnVolumeRampDecay = 1.0 / (timeFactorDecay * this->sampleRate * ((this->globalParameters->decayTime * MAX_DECAY_TIME_SEC) + 0.005));
         if (currentVolume)
@@ -1145,8 +1260,14 @@ void Voice<SamplePrecision>::noteOn (int32 _pitch, ParamValue velocity, float tu
         //////////////////-----------------------------
     //}
     
+	// deterministic per note seed, the same events always render the same noise
+	noise.seed (NoiseRandom::hash ((uint32)nId) ^ (uint32)_pitch);
+	noiseTwo.seed (NoiseRandom::hash ((uint32)nId + 1) ^ (uint32)_pitch);
+
+	envelopeStage = kEnvelopeAttack;
+
 	VoiceBase<kNumParameters, SamplePrecision, 2, GlobalParameterState>::noteOn (_pitch, velocity, tuning, sampleOffset, nId);
-	this->noteOnSampleOffset++;
+	expressionGeneration++;
 }
 
 //-----------------------------------------------------------------------------
@@ -1154,35 +1275,36 @@ template<class SamplePrecision>
 void Voice<SamplePrecision>::noteOff (ParamValue velocity, int32 sampleOffset)
 {
 	VoiceBase<kNumParameters, SamplePrecision, 2, GlobalParameterState>::noteOff (velocity, sampleOffset);
-	this->noteOffSampleOffset++;
-
-	while (!Voice::delayQueue.empty()) {
-		Voice::delayQueue.pop();
-	}
-
-	for (int i = 0; i < 44100 * (300 * this->globalParameters->stereoMs / 1000.00); i++) {
-		Voice::delayQueue.push((SamplePrecision)0);
-	}
+	if (envelopeStage != kEnvelopeDone)
+		envelopeStage = kEnvelopeRelease;
 
 	ParamValue timeFactor;
 	if (this->values[kReleaseTimeMod] == 0)
 		timeFactor = 1;
 	else
-		timeFactor = ::pow (100., this->values[kReleaseTimeMod]);
+		timeFactor = VoiceTables::timeFactor (this->values[kReleaseTimeMod]);
 	
 	noteOffVolumeRamp = 1.0 / (timeFactor * this->sampleRate * ((this->globalParameters->releaseTime * MAX_RELEASE_TIME_SEC) + 0.005));
 	if (currentVolume)
 		noteOffVolumeRamp *= currentVolume;
 }
 
+//-----------------------------------------------------------------------------
+template<class SamplePrecision>
+void Voice<SamplePrecision>::fadeOut (ParamValue seconds)
+{
+	if (envelopeStage == kEnvelopeDone)
+		return;
+	ParamValue ramp = currentVolume / (seconds * this->sampleRate);
+	if (envelopeStage != kEnvelopeRelease || ramp > noteOffVolumeRamp)
+		noteOffVolumeRamp = ramp;
+	envelopeStage = kEnvelopeRelease;
+}
+
 //-----------------------------------------------------------------------------
 template<class SamplePrecision>
 void Voice<SamplePrecision>::reset ()
 {
-	noiseStep = 1;
-    noiseStepTwo = 1;
-	noisePos = 0;
-    noisePosTwo = 0;
 	n = 0;
 	sinusPhase = trianglePhase = 0.;
     sinusPhaseTwo = trianglePhaseTwo = 0.;
@@ -1219,10 +1341,13 @@ void Voice<SamplePrecision>::reset ()
     currentLPOneQ = 0.;
     currentLPTwoFreq = 1.;
     currentLPTwoQ = 0.;
-	filter->reset ();
-    filterOne->reset ();
-    filterTwo->reset ();
+	filter.reset ();
+    filterOne.reset ();
+    filterTwo.reset ();
 	noteOffVolumeRamp = 0.005;
+	currentVolume = 0.;
+	envelopeStage = kEnvelopeDone;
+	expressionGeneration++;
 	
 	VoiceBase<kNumParameters, SamplePrecision, 2, GlobalParameterState>::reset ();
 }
@@ -1231,28 +1356,30 @@ void Voice<SamplePrecision>::reset ()
 template<class SamplePrecision>
 void Voice<SamplePrecision>::setSampleRate (ParamValue sampleRate)
 {
-	filter->setSampleRate (sampleRate);
-    filterOne->setSampleRate (sampleRate);
-    filterTwo->setSampleRate (sampleRate);
+	filter.setSampleRate (sampleRate);
+    filterOne.setSampleRate (sampleRate);
+    filterTwo.setSampleRate (sampleRate);
+	noise.setSampleRate ((SamplePrecision)sampleRate);
+	noiseTwo.setSampleRate ((SamplePrecision)sampleRate);
 	VoiceBase<kNumParameters, SamplePrecision, 2, GlobalParameterState>::setSampleRate(sampleRate);
+	expressionGeneration++;
 }
 
 //-----------------------------------------------------------------------------
 template<class SamplePrecision>
 Voice<SamplePrecision>::Voice ()
+: buffers (nullptr)
+, rampsActive (true)
+, silentBlock (false)
+, audibleGain (0.)
+, filter (Filter::kLowpass)
+, filterOne (Filter::kLowpass)
+, filterTwo (Filter::kLowpass)
+, expressionGeneration (0)
+, derivedExpressionGeneration (0)
+, derivedGlobalGeneration (0)
+, firsttime (true)
 {
-	filter = new Filter (Filter::kLowpass);
-    filterOne = new Filter (Filter::kLowpass);
-    filterTwo = new Filter (Filter::kLowpass);
-}
-
-//-----------------------------------------------------------------------------
-template<class SamplePrecision>
-Voice<SamplePrecision>::~Voice ()
-{
-	delete filter;
-    delete filterOne;
-    delete filterTwo;
 }
 
 }}} // namespaces
\ No newline at end of file
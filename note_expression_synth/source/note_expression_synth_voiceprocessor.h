@@ -0,0 +1,475 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/note_expression_synth_voiceprocessor.h
+// Description : Sample accurate voice processor
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include "pluginterfaces/vst/ivstevents.h"
+#include "parameterautomation.h"
+#include "parametersnapshot.h"
+#include "renderpool.h"
+#include "cpugovernor.h"
+#include "voicearena.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+class SynthVoiceProcessor
+{
+public:
+	SynthVoiceProcessor () : activeVoices (0), renderPool (nullptr) {}
+	virtual ~SynthVoiceProcessor () {}
+
+	/** automation may be nullptr, otherwise its begin () was called for this block */
+	virtual tresult process (ProcessData& data, ParameterAutomation* automation) = 0;
+
+	int32 getActiveVoices () const { return activeVoices; }
+	/** envelope levels of up to maxLevels playing voices, returns how many were written */
+	virtual int32 getVoiceLevels (float* levels, int32 maxLevels) const = 0;
+
+	/** renders the voices on the threads of the pool, nullptr renders on the calling thread */
+	void setRenderPool (RenderPool* pool) { renderPool = pool; }
+protected:
+	int32 activeVoices;
+	RenderPool* renderPool;
+};
+
+//-----------------------------------------------------------------------------
+/** Voice processor which renders the host block in sub-blocks split at every event offset.
+
+	Events are applied exactly at their sample position (always with a sample offset of 0 for
+	the voice), so within one call of VoiceClass::process the voice settings are constant and
+	the voice does not need to count down offsets per sample.
+
+	Sub-blocks are also cut at the automation points (at most every kMinAutomationBlock samples)
+	and the parameters are set to their value at the end of each sub-block before it is
+	rendered, the voices ramp towards them over the sub-block or 5 ms, whichever is longer.
+
+	The voices read the global parameters from the snapshot published last, never from the
+	state the processor is editing.
+
+	With a RenderPool the generators of the voices (VoiceClass::render) run in parallel, the
+	GPU filter and the mix (VoiceClass::mix) follow on the calling thread, which owns the GL
+	context, in voice order.
+
+	Every voice carries a smoothed render cost per sample, measured on the workers. The voices
+	are handed out longest processing time first: sorted by predicted cost, each one goes to
+	the worker with the least predicted load, so a few heavy FM voices do not end up behind
+	each other on one thread.
+
+	The CPU governor level (GlobalParameterState::renderQuality) is applied here as well: quiet
+	releasing voices fade out early, and above half the polyphony a new note fades out the
+	quietest held voice within kDropReleaseTime and starts in a free slot next to it.
+
+	Precision is the sample type of the host buffers, VoiceClass::Sample the one the voices
+	render in. When they differ the voices mix into mixBuffer and every sub-block is converted
+	once into the host buffers, so a 64 bit host can run float voices.
+
+	\sa Steinberg::Vst::VoiceProcessorImplementation
+*/
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+class SynthVoiceProcessorImplementation : public SynthVoiceProcessor, public IRenderTasks
+{
+public:
+	enum
+	{
+		kMinAutomationBlock = 16,
+		kMinParallelVoices = 2		// below this waking the workers costs more than it saves
+	};
+
+	static constexpr float kCostSmoothing = 0.2f;	// weight of the newest measurement
+
+	typedef typename VoiceClass::Sample Sample;
+	static constexpr bool kConvertOutput = !std::is_same<Sample, Precision>::value;
+
+	/** numVoices is the polyphony, voice storage is allocated for exactly that many */
+	SynthVoiceProcessorImplementation (float sampleRate, int32 numVoices, ParameterSnapshots<GlobalParameterStorage>* snapshots);
+
+	tresult process (ProcessData& data, ParameterAutomation* automation) SMTG_OVERRIDE;
+	int32 getVoiceLevels (float* levels, int32 maxLevels) const SMTG_OVERRIDE;
+	void runTask (int32 task) SMTG_OVERRIDE;
+
+protected:
+	void updateGlobalParameters ();
+	void dropQuietReleases ();
+	int32 collectRenderList ();
+	void scheduleRenderList (int32 numRender, int32* chunkEnds);
+	void processEvent (Event& e);
+	void renderVoices (Sample* outputs[numChannels], int32 numSamples);
+	VoiceClass* getVoice (int32 noteId);
+	VoiceClass* findVoice (int32 noteId);
+
+	int32 numVoices;
+	VoiceArena<VoiceClass> voices;
+	std::vector<int32> renderList;		// voices of the parallel sub-block, in schedule order
+	std::vector<int32> renderWorker;	// by schedule position
+	std::vector<int32> renderScheduled;
+	std::vector<uint8> renderPlaying;	// by voice, not vector<bool>: written by several workers
+	std::vector<float> renderCost;		// by voice, smoothed nanoseconds per sample of its note
+	int32 renderSamples;
+	ParameterSnapshots<GlobalParameterStorage>* snapshots;
+	const GlobalParameterStorage* globalParameters;
+	Sample mixBuffer[numChannels][VoiceClass::kMaxSamples];	// kConvertOutput only
+};
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::SynthVoiceProcessorImplementation (float sampleRate, int32 numVoices, ParameterSnapshots<GlobalParameterStorage>* snapshots)
+: numVoices (numVoices)
+, voices (numVoices)
+, renderList (numVoices)
+, renderWorker (numVoices)
+, renderScheduled (numVoices)
+, renderPlaying (numVoices, 0)
+, renderCost (numVoices, 0.f)
+, renderSamples (0)
+, snapshots (snapshots)
+, globalParameters (snapshots->read ())
+{
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		voices[i].setGlobalParameters (globalParameters);
+		voices[i].setSampleRate (sampleRate);
+		voices[i].reset ();
+	}
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+tresult SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::process (ProcessData& data, ParameterAutomation* automation)
+{
+	Precision** channelBuffers = (Precision**)data.outputs[0].channelBuffers32;
+	if (!kConvertOutput) // otherwise every sample is written by the conversion
+	{
+		for (int32 c = 0; c < numChannels; c++)
+			memset (channelBuffers[c], 0, data.numSamples * sizeof (Precision));
+	}
+
+	IEventList* inputEvents = data.inputEvents;
+	int32 numEvents = inputEvents ? inputEvents->getEventCount () : 0;
+	int32 eventIndex = 0;
+	Event e = {};
+	bool hasEvent = numEvents > 0 && inputEvents->getEvent (eventIndex, e) == kResultTrue;
+
+	updateGlobalParameters ();
+	dropQuietReleases ();
+
+	int32 pos = 0;
+	while (pos < data.numSamples)
+	{
+		// apply everything which happens at this sample, notes start with the current parameters
+		if (automation && hasEvent && e.sampleOffset <= pos)
+			automation->applyAt (pos);
+		updateGlobalParameters ();
+		while (hasEvent && e.sampleOffset <= pos)
+		{
+			processEvent (e);
+			hasEvent = ++eventIndex < numEvents && inputEvents->getEvent (eventIndex, e) == kResultTrue;
+		}
+
+		// render up to the next event or automation point
+		int32 end = data.numSamples;
+		if (hasEvent && e.sampleOffset < end)
+			end = e.sampleOffset;
+		end = std::min<int32> (end, pos + VoiceClass::kMaxSamples);
+		if (automation)
+		{
+			end = std::min<int32> (end, automation->nextPointOffset (pos + kMinAutomationBlock - 1));
+			automation->applyAt (end);
+			updateGlobalParameters ();
+		}
+
+		Sample* outputs[numChannels];
+		for (int32 c = 0; c < numChannels; c++)
+		{
+			if (kConvertOutput)
+			{
+				outputs[c] = mixBuffer[c];
+				memset (mixBuffer[c], 0, (end - pos) * sizeof (Sample));
+			}
+			else
+				outputs[c] = reinterpret_cast<Sample*> (channelBuffers[c] + pos);
+		}
+		renderVoices (outputs, end - pos);
+		if (kConvertOutput)
+		{
+			for (int32 c = 0; c < numChannels; c++)
+			{
+				Precision* out = channelBuffers[c] + pos;
+				for (int32 i = 0; i < end - pos; i++)
+					out[i] = (Precision)mixBuffer[c][i];
+			}
+		}
+
+		pos = end;
+	}
+
+	// events at or behind the end of the block (or in a block without samples) still happen,
+	// at its last sample: a lost note off would leave its note playing
+	if (hasEvent)
+	{
+		if (automation)
+			automation->applyAt (data.numSamples);
+		updateGlobalParameters ();
+		while (hasEvent)
+		{
+			processEvent (e);
+			hasEvent = ++eventIndex < numEvents && inputEvents->getEvent (eventIndex, e) == kResultTrue;
+		}
+	}
+	return kResultTrue;
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::renderVoices (Sample* outputs[numChannels], int32 numSamples)
+{
+	if (renderPool && renderPool->getNumThreads () > 0 && activeVoices >= kMinParallelVoices)
+	{
+		int32 chunkEnds[RenderPool::kMaxThreads + 1];
+		int32 numRender = collectRenderList ();
+		scheduleRenderList (numRender, chunkEnds);
+		renderSamples = numSamples;
+		renderPool->run (this, numRender, chunkEnds);
+
+		// mixed in voice order, the schedule does not change the sum
+		for (int32 i = 0; i < numVoices; i++)
+		{
+			if (voices[i].getNoteId () == -1)
+				continue;
+			voices[i].mix (outputs, numSamples);
+			if (!renderPlaying[i])
+			{
+				voices[i].reset ();
+				activeVoices--;
+			}
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		if (voices[i].getNoteId () == -1)
+			continue;
+		if (!voices[i].process (outputs, numSamples))
+		{
+			voices[i].reset ();
+			activeVoices--;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::runTask (int32 task)
+{
+	int32 index = renderList[task];
+	auto start = std::chrono::steady_clock::now ();
+	renderPlaying[index] = voices[index].render (renderSamples);
+	auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start);
+
+	float cost = (float)nanos.count () / (float)renderSamples;
+	renderCost[index] += kCostSmoothing * (cost - renderCost[index]);
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+int32 SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::collectRenderList ()
+{
+	int32 numRender = 0;
+	float knownCost = 0.f;
+	int32 numKnown = 0;
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		if (voices[i].getNoteId () == -1)
+			continue;
+		renderList[numRender++] = i;
+		if (renderCost[i] > 0.f)
+		{
+			knownCost += renderCost[i];
+			numKnown++;
+		}
+	}
+	// voices without a measurement yet are expected to cost what the others do
+	float defaultCost = numKnown > 0 ? knownCost / numKnown : 1.f;
+	for (int32 i = 0; i < numRender; i++)
+	{
+		if (renderCost[renderList[i]] <= 0.f)
+			renderCost[renderList[i]] = defaultCost;
+	}
+	return numRender;
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::scheduleRenderList (int32 numRender, int32* chunkEnds)
+{
+	int32 numWorkers = renderPool->getNumWorkers ();
+	float load[RenderPool::kMaxThreads + 1] = {};
+	int32 count[RenderPool::kMaxThreads + 1] = {};
+
+	// longest processing time first, each voice to the least loaded worker
+	std::sort (renderList.begin (), renderList.begin () + numRender,
+	           [this] (int32 a, int32 b) { return renderCost[a] > renderCost[b]; });
+	for (int32 i = 0; i < numRender; i++)
+	{
+		int32 best = 0;
+		for (int32 w = 1; w < numWorkers; w++)
+		{
+			if (load[w] < load[best])
+				best = w;
+		}
+		load[best] += renderCost[renderList[i]];
+		count[best]++;
+		renderWorker[i] = best;
+	}
+
+	// make every worker's voices one chunk, still heaviest first within it
+	int32 next[RenderPool::kMaxThreads + 1];
+	int32 end = 0;
+	for (int32 w = 0; w < numWorkers; w++)
+	{
+		next[w] = end;
+		end += count[w];
+		chunkEnds[w] = end;
+	}
+	for (int32 i = 0; i < numRender; i++)
+		renderScheduled[next[renderWorker[i]]++] = renderList[i];
+	std::copy (renderScheduled.begin (), renderScheduled.begin () + numRender, renderList.begin ());
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::updateGlobalParameters ()
+{
+	const GlobalParameterStorage* snapshot = snapshots->read ();
+	if (snapshot == globalParameters)
+		return;
+	globalParameters = snapshot;
+	for (int32 i = 0; i < numVoices; i++)
+		voices[i].setGlobalParameters (globalParameters);
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::dropQuietReleases ()
+{
+	if (globalParameters->renderQuality < CpuGovernor::kDropReleases)
+		return;
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		VoiceClass& voice = voices[i];
+		if (voice.getNoteId () != -1 && voice.isReleasing () && voice.getEnvelopeLevel () < CpuGovernor::kDropReleaseLevel)
+			voice.fadeOut (CpuGovernor::kDropReleaseTime);
+	}
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+void SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::processEvent (Event& e)
+{
+	switch (e.type)
+	{
+		case Event::kNoteOnEvent:
+		{
+			if (e.noteOn.noteId == -1)
+				e.noteOn.noteId = e.noteOn.pitch;
+			if (VoiceClass* voice = getVoice (e.noteOn.noteId))
+			{
+				if (voice->getNoteId () == -1)
+					activeVoices++;
+				// the cost measured for the previous note says nothing about this one
+				renderCost[voices.indexOf (*voice)] = 0.f;
+				voice->noteOn (e.noteOn.pitch, e.noteOn.velocity, e.noteOn.tuning, 0, e.noteOn.noteId);
+			}
+			break;
+		}
+		case Event::kNoteOffEvent:
+		{
+			if (e.noteOff.noteId == -1)
+				e.noteOff.noteId = e.noteOff.pitch;
+			if (VoiceClass* voice = findVoice (e.noteOff.noteId))
+				voice->noteOff (e.noteOff.velocity, 0);
+			break;
+		}
+		case Event::kNoteExpressionValueEvent:
+		{
+			if (VoiceClass* voice = findVoice (e.noteExpressionValue.noteId))
+				voice->setNoteExpressionValue (e.noteExpressionValue.typeId, e.noteExpressionValue.value);
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+VoiceClass* SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::getVoice (int32 noteId)
+{
+	VoiceClass* freeVoice = nullptr;
+	VoiceClass* quietest = nullptr;	// of the held voices
+	int32 heldVoices = 0;
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		VoiceClass& voice = voices[i];
+		if (voice.getNoteId () == noteId)
+			return &voice;
+		if (voice.getNoteId () == -1)
+		{
+			if (freeVoice == nullptr)
+				freeVoice = &voice;
+		}
+		else if (!voice.isReleasing ())
+		{
+			heldVoices++;
+			if (quietest == nullptr || voice.getEnvelopeLevel () < quietest->getEnvelopeLevel ())
+				quietest = &voice;
+		}
+	}
+
+	// the victim keeps its slot until it has faded, releasing voices (earlier victims among
+	// them) do not count. Without a free slot the note is dropped as at full polyphony.
+	if (globalParameters->renderQuality >= CpuGovernor::kReducedPolyphony && heldVoices >= numVoices / 2 &&
+	    quietest && freeVoice)
+		quietest->fadeOut (CpuGovernor::kDropReleaseTime);
+	return freeVoice;
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+VoiceClass* SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::findVoice (int32 noteId)
+{
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		if (voices[i].getNoteId () == noteId)
+			return &voices[i];
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+template<class Precision, class VoiceClass, int32 numChannels, class GlobalParameterStorage>
+int32 SynthVoiceProcessorImplementation<Precision, VoiceClass, numChannels, GlobalParameterStorage>::getVoiceLevels (float* levels, int32 maxLevels) const
+{
+	int32 count = 0;
+	for (int32 i = 0; i < numVoices && count < maxLevels; i++)
+	{
+		if (voices[i].getNoteId () != -1)
+			levels[count++] = (float)voices[i].getEnvelopeLevel ();
+	}
+	return count;
+}
+
+}}} // namespaces
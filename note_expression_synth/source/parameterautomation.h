@@ -0,0 +1,239 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/parameterautomation.h
+// Description : Reads every point of the input parameter queues as a piecewise linear curve
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstparameterchanges.h"
+#include <climits>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+class IParameterTarget
+{
+public:
+	virtual ~IParameterTarget () {}
+
+	virtual void applyParameter (ParamID id, ParamValue value) = 0;
+	/** called after a batch of applyParameter calls */
+	virtual void endParameterChanges () = 0;
+};
+
+//-----------------------------------------------------------------------------
+/** Piecewise linear view of the IParamValueQueues of one process call.
+
+	Between two points the value is linear (the VST 3 automation model). Before the first point
+	of a block it ramps from the value the parameter had at the end of the previous block.
+
+	The voice processor asks nextPointOffset for where to cut its sub-blocks and calls applyAt
+	with the end of each sub-block, so the voices see every point of the host curve instead of
+	only the last one of the block. They ramp to each new value over the sub-block, but over
+	at least 5 ms (Voice::render): the curve is followed with that much smoothing, not exactly.
+*/
+class ParameterAutomation
+{
+public:
+	enum
+	{
+		kMaxParameters = 64,	// parameter ids at or above are not automated
+		kNoPoint = INT_MAX
+	};
+
+	ParameterAutomation () : target (nullptr), numLanes (0) { reset (); }
+
+	/** forget the values of the previous block (after setState or setActive) */
+	void reset ();
+
+	void begin (IParameterChanges* inputChanges, IParameterTarget* target);
+	void end ();
+
+	/** first point offset after the given sample, kNoPoint when there is none */
+	int32 nextPointOffset (int32 after) const;
+	/** sets all automated parameters to their value at sampleOffset */
+	void applyAt (int32 sampleOffset);
+
+protected:
+	struct Lane
+	{
+		IParamValueQueue* queue;
+		ParamID id;
+		int32 numPoints;
+		int32 nextIndex;
+		int32 prevOffset;
+		ParamValue prevValue;
+		int32 nextOffset;
+		ParamValue nextValue;
+		ParamValue appliedValue;
+	};
+
+	void advance (Lane& lane);
+	ParamValue valueAt (Lane& lane, int32 sampleOffset);
+
+	IParameterTarget* target;
+	Lane lanes[kMaxParameters];
+	int32 numLanes;
+	ParamValue lastValue[kMaxParameters];
+	bool hasLastValue[kMaxParameters];
+};
+
+//-----------------------------------------------------------------------------
+inline void ParameterAutomation::reset ()
+{
+	for (int32 i = 0; i < kMaxParameters; i++)
+	{
+		lastValue[i] = 0.;
+		hasLastValue[i] = false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline void ParameterAutomation::begin (IParameterChanges* inputChanges, IParameterTarget* _target)
+{
+	target = _target;
+	numLanes = 0;
+	if (inputChanges == nullptr)
+		return;
+
+	int32 count = inputChanges->getParameterCount ();
+	for (int32 i = 0; i < count && numLanes < kMaxParameters; i++)
+	{
+		IParamValueQueue* queue = inputChanges->getParameterData (i);
+		if (queue == nullptr || queue->getPointCount () <= 0)
+			continue;
+		ParamID id = queue->getParameterId ();
+		if (id >= (ParamID)kMaxParameters)
+			continue;
+
+		Lane& lane = lanes[numLanes];
+		lane.queue = queue;
+		lane.id = id;
+		lane.numPoints = queue->getPointCount ();
+		lane.nextIndex = 0;
+		advance (lane);
+		lane.prevOffset = 0;
+		lane.prevValue = hasLastValue[id] ? lastValue[id] : lane.nextValue;
+		lane.appliedValue = -1.;
+		numLanes++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline void ParameterAutomation::end ()
+{
+	bool changed = false;
+	for (int32 i = 0; i < numLanes; i++)
+	{
+		Lane& lane = lanes[i];
+		while (lane.nextOffset != kNoPoint)
+		{
+			lane.prevValue = lane.nextValue;
+			advance (lane);
+		}
+		if (lane.appliedValue != lane.prevValue && target)
+		{
+			target->applyParameter (lane.id, lane.prevValue);
+			changed = true;
+		}
+		lastValue[lane.id] = lane.prevValue;
+		hasLastValue[lane.id] = true;
+	}
+	if (changed)
+		target->endParameterChanges ();
+	numLanes = 0;
+	target = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+inline int32 ParameterAutomation::nextPointOffset (int32 after) const
+{
+	int32 result = kNoPoint;
+	for (int32 i = 0; i < numLanes; i++)
+	{
+		const Lane& lane = lanes[i];
+		if (lane.nextOffset == kNoPoint)
+			continue;
+		if (lane.nextOffset > after)
+		{
+			if (lane.nextOffset < result)
+				result = lane.nextOffset;
+			continue;
+		}
+		// the lane cursor only moves in applyAt, look further ahead without moving it
+		for (int32 index = lane.nextIndex; index < lane.numPoints; index++)
+		{
+			int32 offset;
+			ParamValue value;
+			if (lane.queue->getPoint (index, offset, value) == kResultTrue && offset > after)
+			{
+				if (offset < result)
+					result = offset;
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+inline void ParameterAutomation::applyAt (int32 sampleOffset)
+{
+	if (target == nullptr)
+		return;
+	bool changed = false;
+	for (int32 i = 0; i < numLanes; i++)
+	{
+		Lane& lane = lanes[i];
+		ParamValue value = valueAt (lane, sampleOffset);
+		if (value != lane.appliedValue)
+		{
+			lane.appliedValue = value;
+			target->applyParameter (lane.id, value);
+			changed = true;
+		}
+	}
+	if (changed)
+		target->endParameterChanges ();
+}
+
+//-----------------------------------------------------------------------------
+inline void ParameterAutomation::advance (Lane& lane)
+{
+	lane.nextOffset = kNoPoint;
+	while (lane.nextIndex < lane.numPoints)
+	{
+		int32 offset;
+		ParamValue value;
+		if (lane.queue->getPoint (lane.nextIndex++, offset, value) == kResultTrue)
+		{
+			lane.nextOffset = offset;
+			lane.nextValue = value;
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline ParamValue ParameterAutomation::valueAt (Lane& lane, int32 sampleOffset)
+{
+	while (lane.nextOffset != kNoPoint && lane.nextOffset <= sampleOffset)
+	{
+		lane.prevOffset = lane.nextOffset;
+		lane.prevValue = lane.nextValue;
+		advance (lane);
+	}
+	if (lane.nextOffset == kNoPoint)
+		return lane.prevValue;
+
+	ParamValue pos = (ParamValue)(sampleOffset - lane.prevOffset) / (ParamValue)(lane.nextOffset - lane.prevOffset);
+	return lane.prevValue + (lane.nextValue - lane.prevValue) * pos;
+}
+
+}}} // namespaces
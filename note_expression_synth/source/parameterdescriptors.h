@@ -0,0 +1,219 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/parameterdescriptors.h
+// Description : One table describing every global parameter
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "note_expression_synth_controller.h"
+#include "note_expression_synth_voice.h"
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Describes one global parameter: how the processor maps it into GlobalParameterState, where
+	it lives in the state stream and how the controller presents it.
+*/
+struct ParameterDescriptor
+{
+	enum Transform
+	{
+		kNone,			// not stored in GlobalParameterState (read only)
+		kLinear,		// field = normalized
+		kBipolar,		// field = [-1, +1]
+		kStepped,		// int8 field = [0, numSteps - 1]
+		kSwitch,		// int8 field = 0 or 1
+		kTrigger		// not stored, the processor acts on it
+	};
+
+	enum Kind
+	{
+		kRange,			// RangeParameter
+		kLogFrequency,	// LogScaleParameter on VoiceStatics::freqLogScale
+		kStringList,	// StringListParameter
+		kPlain			// Parameter
+	};
+
+	enum { kNotStored = -1 };
+
+	ParamID id;
+	Transform transform;
+	ParamValue GlobalParameterState::* value;
+	int8 GlobalParameterState::* step;
+	int32 numSteps;			// number of discrete values, 0 for continuous parameters
+	int32 stateVersion;		// first state version containing the field
+
+	Kind kind;
+	const char* title;
+	const char* units;
+	ParamValue minPlain;
+	ParamValue maxPlain;
+	ParamValue defaultValue;	// plain for kRange, normalized otherwise
+	int32 precision;
+	int32 flags;
+	const char* const* strings;	// kStringList, nullptr terminated
+
+	inline void apply (GlobalParameterState& state, ParamValue normalized) const
+	{
+		switch (transform)
+		{
+			case kLinear: state.*value = normalized; break;
+			case kBipolar: state.*value = 2 * (normalized - 0.5); break;
+			case kStepped: state.*step = std::min<int8> ((int8) (numSteps * normalized), numSteps - 1); break;
+			case kSwitch: state.*step = (normalized >= 0.5) ? 1 : 0; break;
+			default: break;
+		}
+	}
+
+	inline ParamValue getNormalized (const GlobalParameterState& state) const
+	{
+		switch (transform)
+		{
+			case kLinear: return state.*value;
+			case kBipolar: return (state.*value + 1) / 2.;
+			case kStepped: return numSteps > 1 ? (ParamValue)(state.*step) / (numSteps - 1) : 0.;
+			case kSwitch: return state.*step;
+			default: return 0.;
+		}
+	}
+};
+
+//-----------------------------------------------------------------------------
+static constexpr const char* kOscTypeStrings[] = {"Sinus", "Square", "Triangle", "Noise", nullptr};
+static constexpr const char* kFilterTypeStrings[] = {"Lowpass", "Highpass", "Bandpass", nullptr};
+static constexpr const char* kTuningRangeStrings[] = {"[-1, +1] Octave", "[-3, +2] Tunes", nullptr};
+static constexpr const char* kEnginePrecisionStrings[] = {"32 Bit", "64 Bit", nullptr};
+static constexpr const char* kCpuGovernorStrings[] = {"Full Quality", "Coarse Control Rate", "Fast Oscillators", "Drop Releases", "Reduced Polyphony", nullptr};
+
+typedef ParameterDescriptor PD;
+typedef GlobalParameterState GPS;
+
+//-----------------------------------------------------------------------------
+/** All global parameters, in the order of the state stream (GlobalParameterState::setState). */
+static constexpr ParameterDescriptor kParameterDescriptors[] = {
+	// version 0
+	{kParamNoiseVolume, PD::kLinear, &GPS::noiseVolume, nullptr, 0, 0, PD::kRange, "Noise Volume", "%", 0, 100, 0, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamNoiseVolumeTwo, PD::kLinear, &GPS::noiseVolumeTwo, nullptr, 0, 0, PD::kRange, "Noise Volume Two", "%", 0, 100, 0, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSinusVolume, PD::kLinear, &GPS::sinusVolume, nullptr, 0, 0, PD::kRange, "Sinus Volume", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSinusVolumeTwo, PD::kLinear, &GPS::sinusVolumeTwo, nullptr, 0, 0, PD::kRange, "Sinus Volume Two", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamTriangleVolume, PD::kLinear, &GPS::triangleVolume, nullptr, 0, 0, PD::kRange, "Triangle Volume", "%", 0, 100, 20, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamTriangleVolumeTwo, PD::kLinear, &GPS::triangleVolumeTwo, nullptr, 0, 0, PD::kRange, "Triangle Volume Two", "%", 0, 100, 20, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamReleaseTime, PD::kLinear, &GPS::releaseTime, nullptr, 0, 0, PD::kRange, "Release Time", "sec", 0.005, MAX_RELEASE_TIME_SEC, 0.025, 3, ParameterInfo::kCanAutomate, nullptr},
+	{kParamAttackTime, PD::kLinear, &GPS::attackTime, nullptr, 0, 0, PD::kRange, "AttackTime", "sec", 0.005, MAX_ATTACK_TIME_SEC, 0.025, 3, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSustainVolume, PD::kLinear, &GPS::sustainVolume, nullptr, 0, 0, PD::kRange, "Sustain Volume", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamDecayTime, PD::kLinear, &GPS::decayTime, nullptr, 0, 0, PD::kRange, "DecayTime", "sec", 0.005, MAX_ATTACK_TIME_SEC, 0.025, 3, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSinusDetune, PD::kBipolar, &GPS::sinusDetune, nullptr, 0, 0, PD::kRange, "Sinus Detune", "cent", -200, 200, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSinusDetuneTwo, PD::kBipolar, &GPS::sinusDetuneTwo, nullptr, 0, 0, PD::kRange, "Sinus Detune Two", "cent", -200, 200, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamTriangleSlop, PD::kLinear, &GPS::triangleSlop, nullptr, 0, 0, PD::kRange, "Triangle Slop", "%", 0, 100, 50, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamTriangleSlopTwo, PD::kLinear, &GPS::triangleSlopTwo, nullptr, 0, 0, PD::kRange, "Triangle Slop Two", "%", 0, 100, 50, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamBypassSNA, PD::kSwitch, nullptr, &GPS::bypassSNA, 2, 0, PD::kPlain, "Bypass SNA", nullptr, 0, 1, 0, 4, ParameterInfo::kCanAutomate, nullptr},
+
+	// version 1
+	{kParamGenFreqOne, PD::kLinear, &GPS::genFreqOne, nullptr, 0, 1, PD::kLogFrequency, "Gen Frequency One", nullptr, 0, 1, 0, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamGenFreqTwo, PD::kLinear, &GPS::genFreqTwo, nullptr, 0, 1, PD::kLogFrequency, "Gen Frequency Two", nullptr, 0, 1, 0, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamStereoMs, PD::kLinear, &GPS::stereoMs, nullptr, 0, 1, PD::kRange, "Stereo ms", "%", 0, 300, 0, 2, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterType, PD::kStepped, nullptr, &GPS::filterType, NUM_FILTER_TYPE, 1, PD::kStringList, "Filter Type", nullptr, 0, 0, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kFilterTypeStrings},
+	{kParamFilterFreq, PD::kLinear, &GPS::filterFreq, nullptr, 0, 1, PD::kLogFrequency, "Filter Frequency", nullptr, 0, 1, 1, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterQ, PD::kLinear, &GPS::filterQ, nullptr, 0, 1, PD::kPlain, "Filter Q", nullptr, 0, 1, 0, 2, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterOneType, PD::kStepped, nullptr, &GPS::filterOneType, NUM_FILTER_TYPE, 1, PD::kStringList, "Filter One Type", nullptr, 0, 0, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kFilterTypeStrings},
+	{kParamFilterOneFreq, PD::kLinear, &GPS::filterOneFreq, nullptr, 0, 1, PD::kLogFrequency, "Filter One Frequency", nullptr, 0, 1, 1, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterOneQ, PD::kLinear, &GPS::filterOneQ, nullptr, 0, 1, PD::kPlain, "Filter One Q", nullptr, 0, 1, 0, 2, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterTwoType, PD::kStepped, nullptr, &GPS::filterTwoType, NUM_FILTER_TYPE, 1, PD::kStringList, "Filter Two Type", nullptr, 0, 0, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kFilterTypeStrings},
+	{kParamFilterTwoFreq, PD::kLinear, &GPS::filterTwoFreq, nullptr, 0, 1, PD::kLogFrequency, "Filter Two Frequency", nullptr, 0, 1, 1, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterTwoQ, PD::kLinear, &GPS::filterTwoQ, nullptr, 0, 1, PD::kPlain, "Filter Two Q", nullptr, 0, 1, 0, 2, ParameterInfo::kCanAutomate, nullptr},
+	{kParamOscType, PD::kStepped, nullptr, &GPS::oscType, NUM_OSC_TYPE, 1, PD::kStringList, "Osc Type", nullptr, 0, 0, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kOscTypeStrings},
+	{kParamOscTypeTwo, PD::kStepped, nullptr, &GPS::oscTypeTwo, NUM_OSC_TYPE_TWO, 1, PD::kStringList, "Osc Type Two", nullptr, 0, 0, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kOscTypeStrings},
+	{kParamFreqModOn, PD::kLinear, &GPS::freqModOn, nullptr, 0, 1, PD::kRange, "Freq Mod On", "%", 0, 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSaveState, PD::kTrigger, &GPS::saveState, nullptr, 0, 1, PD::kRange, "Save", "%", 0, 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamLoadState, PD::kTrigger, &GPS::loadState, nullptr, 0, 1, PD::kRange, "Load", "%", 0, 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilePath, PD::kLinear, &GPS::filePath, nullptr, 0, 1, PD::kPlain, "File Path", nullptr, 0, 1, 0, 4, ParameterInfo::kCanAutomate, nullptr},
+
+	// version 2
+	{kParamMasterVolume, PD::kLinear, &GPS::masterVolume, nullptr, 0, 2, PD::kRange, "Master Volume", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamMasterTuning, PD::kBipolar, &GPS::masterTuning, nullptr, 0, 2, PD::kRange, "Master Tuning", "cent", -200, 200, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamVelToLevel, PD::kLinear, &GPS::velToLevel, nullptr, 0, 2, PD::kRange, "Velocity To Level", "%", 0, 100, 100, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterFreqModDepth, PD::kBipolar, &GPS::freqModDepth, nullptr, 0, 2, PD::kRange, "Frequency Mod Depth", "%", -100, 100, 100, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamTuningRange, PD::kStepped, nullptr, &GPS::tuningRange, NUM_TUNING_RANGE, 2, PD::kStringList, "Tuning Range", nullptr, 0, 0, 0, 0, ParameterInfo::kIsList, kTuningRangeStrings},
+
+	// version 3
+	{kParamSquareVolume, PD::kLinear, &GPS::squareVolume, nullptr, 0, 3, PD::kRange, "Square Volume", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamSquareVolumeTwo, PD::kLinear, &GPS::squareVolumeTwo, nullptr, 0, 3, PD::kRange, "Square Volume Two", "%", 0, 100, 80, 1, ParameterInfo::kCanAutomate, nullptr},
+
+	// version 4
+	{kParamRenderThreads, PD::kStepped, nullptr, &GPS::renderThreads, MAX_RENDER_THREADS + 1, 4, PD::kRange, "Render Threads", nullptr, 0, MAX_RENDER_THREADS, 0, 0, 0, nullptr},
+
+	// version 5
+	{kParamAudibilityThreshold, PD::kLinear, &GPS::audibilityThreshold, nullptr, 0, 5, PD::kRange, "Audibility Threshold", "dB", MIN_AUDIBILITY_THRESHOLD_DB, MAX_AUDIBILITY_THRESHOLD_DB, -96, 0, ParameterInfo::kCanAutomate, nullptr},
+
+	// version 6
+	{kParamPolyphony, PD::kLinear, &GPS::polyphony, nullptr, MAX_POLYPHONY, 6, PD::kRange, "Polyphony", nullptr, 1, MAX_POLYPHONY, DEFAULT_POLYPHONY, 0, ParameterInfo::kIsHidden, nullptr},
+
+	// version 7
+	{kParamHighPrecision, PD::kSwitch, nullptr, &GPS::highPrecision, 2, 7, PD::kStringList, "Engine Precision", nullptr, 0, 0, 0, 0, ParameterInfo::kIsList, kEnginePrecisionStrings},
+
+	// version 8
+	{kParamMorph, PD::kLinear, &GPS::morph, nullptr, 0, 8, PD::kRange, "Morph", "%", 0, 100, 0, 1, ParameterInfo::kCanAutomate, nullptr},
+
+	// not part of the state
+	{kParamBankPreset, PD::kTrigger, nullptr, nullptr, MAX_BANK_PRESETS, PD::kNotStored, PD::kRange, "Bank Preset", nullptr, 0, MAX_BANK_PRESETS - 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamMorphStoreA, PD::kTrigger, &GPS::morphStoreA, nullptr, 0, PD::kNotStored, PD::kRange, "Store Morph A", "%", 0, 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamMorphStoreB, PD::kTrigger, &GPS::morphStoreB, nullptr, 0, PD::kNotStored, PD::kRange, "Store Morph B", "%", 0, 1, 0, 0, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterOneFreqModDepth, PD::kBipolar, &GPS::freqOneModDepth, nullptr, 0, PD::kNotStored, PD::kRange, "Frequency One Mod Depth", "%", -100, 100, 100, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamFilterTwoFreqModDepth, PD::kBipolar, &GPS::freqTwoModDepth, nullptr, 0, PD::kNotStored, PD::kRange, "Frequency Two Mod Depth", "%", -100, 100, 100, 1, ParameterInfo::kCanAutomate, nullptr},
+	{kParamActiveVoices, PD::kNone, nullptr, nullptr, MAX_POLYPHONY + 1, PD::kNotStored, PD::kRange, "Active Voices", nullptr, 0, MAX_POLYPHONY, 0, 4, ParameterInfo::kIsReadOnly, nullptr},
+	{kParamCpuGovernor, PD::kNone, nullptr, nullptr, CpuGovernor::kNumLevels, PD::kNotStored, PD::kStringList, "CPU Governor", nullptr, 0, 0, 0, 0, ParameterInfo::kIsReadOnly | ParameterInfo::kIsList, kCpuGovernorStrings},
+};
+
+static constexpr int32 kNumParameterDescriptors = sizeof (kParameterDescriptors) / sizeof (kParameterDescriptors[0]);
+static_assert (kNumParameterDescriptors == kNumGlobalParameters, "every global parameter needs a descriptor");
+static_assert (kNumGlobalParameters <= 64, "changedParameters has one bit per parameter");
+
+//-----------------------------------------------------------------------------
+/** Bytes of the state record of a state version (GlobalParameterState::getState): every stored
+	field of the version in table order, ParamValue fields as 8 bytes and int8 fields as 1 byte,
+	little endian without padding. */
+static constexpr uint32 stateRecordSize (uint32 version)
+{
+	uint32 size = 0;
+	for (int32 i = 0; i < kNumParameterDescriptors; i++)
+	{
+		const ParameterDescriptor& desc = kParameterDescriptors[i];
+		if (desc.stateVersion != ParameterDescriptor::kNotStored && (uint32)desc.stateVersion <= version)
+			size += desc.value ? sizeof (double) : sizeof (int8);
+	}
+	return size;
+}
+
+static constexpr uint32 kStateRecordSize = stateRecordSize (GlobalParameterState::kStateVersion);
+
+//-----------------------------------------------------------------------------
+/** Maps a ParamID to its entry in kParameterDescriptors. */
+struct ParameterDescriptorIndex
+{
+	int8 entry[kNumGlobalParameters];
+
+	constexpr ParameterDescriptorIndex () : entry ()
+	{
+		for (int32 i = 0; i < kNumGlobalParameters; i++)
+			entry[i] = -1;
+		for (int32 i = 0; i < kNumParameterDescriptors; i++)
+			entry[kParameterDescriptors[i].id] = (int8)i;
+	}
+
+	inline const ParameterDescriptor* find (ParamID id) const
+	{
+		if (id >= (ParamID)kNumGlobalParameters || entry[id] < 0)
+			return nullptr;
+		return &kParameterDescriptors[entry[id]];
+	}
+};
+
+static constexpr ParameterDescriptorIndex kParameterDescriptorIndex {};
+
+}}} // namespaces
@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/parametersnapshot.h
+// Description : Double buffered, atomically published copies of the global parameters
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Immutable snapshots of a parameter state for readers on other threads.
+
+	The process thread edits its own working copy and calls publish: the copy goes into the
+	buffer nobody was handed out last and one atomic pointer store makes it current. Readers
+	take read () once and use that snapshot for the whole unit of work (a render sub-block).
+
+	With two buffers a snapshot stays valid until the second publish after it was read. The
+	render workers are joined before the processor publishes again, so they always see one
+	consistent state without locks.
+*/
+template<class State>
+class ParameterSnapshots
+{
+public:
+	ParameterSnapshots () : current (&buffers[0]) {}
+
+	/** process thread only */
+	void publish (const State& state)
+	{
+		State* next = current.load (std::memory_order_relaxed) == &buffers[0] ? &buffers[1] : &buffers[0];
+		*next = state;
+		current.store (next, std::memory_order_release);
+	}
+
+	/** any thread */
+	const State* read () const { return current.load (std::memory_order_acquire); }
+
+protected:
+	ParameterSnapshots (const ParameterSnapshots&) = delete;
+	ParameterSnapshots& operator= (const ParameterSnapshots&) = delete;
+
+	State buffers[2];
+	std::atomic<State*> current;
+};
+
+}}} // namespaces
@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/pointerexchange.h
+// Description : Hands immutable objects to the audio thread by an atomic pointer swap
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Hands objects (tuning tables, preset banks) from the message thread to the audio thread.
+
+	The audio thread announces the object it reads (a hazard pointer) and publish only frees
+	replaced objects nobody reads anymore, the others are freed by a later publish or the
+	destructor. acquire never blocks or frees.
+*/
+template<class T>
+class PointerExchange
+{
+public:
+	PointerExchange () : current (nullptr), inUse (nullptr) {}
+	~PointerExchange ()
+	{
+		for (auto object : retired)
+			delete object;
+		delete current.load ();
+	}
+
+	/** takes ownership (nullptr removes the current object), any thread but the audio thread */
+	void publish (T* object)
+	{
+		std::lock_guard<std::mutex> lock (publishMutex);
+		T* previous = current.exchange (object);
+		if (previous)
+			retired.push_back (previous);
+		collect ();
+	}
+
+	/** audio thread, once per block: the object to read until the next acquire */
+	const T* acquire ()
+	{
+		// announce the object, then make sure it was not replaced before the announcement was seen
+		const T* object = current.load ();
+		while (true)
+		{
+			inUse.store (object);
+			const T* check = current.load ();
+			if (check == object)
+				return object;
+			object = check;
+		}
+	}
+
+	/** the audio thread has stopped reading (setActive (false)) */
+	void release () { inUse.store (nullptr); }
+
+protected:
+	void collect ()
+	{
+		const T* reading = inUse.load ();
+		retired.erase (std::remove_if (retired.begin (), retired.end (), [reading] (T* object) {
+			               if (object == reading)
+				               return false;
+			               delete object;
+			               return true;
+		               }),
+		               retired.end ());
+	}
+
+	std::atomic<T*> current;
+	std::atomic<const T*> inUse;
+	std::mutex publishMutex;
+	std::vector<T*> retired;	// publishMutex
+};
+
+}}} // namespaces
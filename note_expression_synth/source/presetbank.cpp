@@ -0,0 +1,199 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/presetbank.cpp
+// Description : Memory mapped bank of presets with fixed size records
+//
+//-----------------------------------------------------------------------------
+
+#include "presetbank.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+static const char kBankMagic[4] = {'N', 'E', 'S', 'B'};
+
+//-----------------------------------------------------------------------------
+PresetBank::PresetBank ()
+: data (nullptr), size (0), header (nullptr), index (nullptr), numPresets (0)
+#if defined(_WIN32)
+, fileHandle (nullptr), mappingHandle (nullptr)
+#endif
+{
+}
+
+//-----------------------------------------------------------------------------
+PresetBank::~PresetBank ()
+{
+	close ();
+}
+
+//-----------------------------------------------------------------------------
+uint32 PresetBank::numValuesOfVersion (uint32 paramVersion)
+{
+	uint32 count = 0;
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (desc.stateVersion != ParameterDescriptor::kNotStored && (uint32)desc.stateVersion <= paramVersion)
+			count++;
+	}
+	return count;
+}
+
+//-----------------------------------------------------------------------------
+bool PresetBank::open (const char* path)
+{
+	close ();
+
+#if defined(_WIN32)
+	// the path is UTF-8, the ANSI functions would read it in the local code page
+	int pathLength = MultiByteToWideChar (CP_UTF8, MB_ERR_INVALID_CHARS, path, -1, nullptr, 0);
+	if (pathLength <= 0)
+		return false;
+	std::vector<wchar_t> widePath (pathLength);
+	MultiByteToWideChar (CP_UTF8, MB_ERR_INVALID_CHARS, path, -1, widePath.data (), pathLength);
+	HANDLE file = CreateFileW (widePath.data (), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx (file, &fileSize) && fileSize.QuadPart > 0)
+		mapping = CreateFileMappingW (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle (file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const char*)MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+	size = (uint64)fileSize.QuadPart;
+#else
+	int file = ::open (path, O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat info;
+	void* mapped = MAP_FAILED;
+	if (fstat (file, &info) == 0 && info.st_size > 0)
+		mapped = mmap (nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close (file); // the mapping keeps the file
+	if (mapped == MAP_FAILED)
+		return false;
+	// start reading the pages in now, the audio thread touches them later
+	madvise (mapped, (size_t)info.st_size, MADV_WILLNEED);
+	data = (const char*)mapped;
+	size = (uint64)info.st_size;
+#endif
+	if (data == nullptr)
+	{
+		close ();
+		return false;
+	}
+
+	// everything getPreset reads is checked once here
+	header = (const BankHeader*)data;
+	if (size < sizeof (BankHeader) || memcmp (header->magic, kBankMagic, sizeof (kBankMagic)) != 0 ||
+	    header->bankVersion != kBankVersion || header->paramVersion > GlobalParameterState::kStateVersion ||
+	    header->numValues != numValuesOfVersion (header->paramVersion) ||
+	    header->indexOffset % sizeof (uint64) != 0 || header->indexOffset > size ||
+	    (size - header->indexOffset) / sizeof (IndexEntry) < header->numPresets)
+	{
+		close ();
+		return false;
+	}
+	index = (const IndexEntry*)(data + header->indexOffset);
+	uint64 recordSize = header->numValues * sizeof (double);
+	for (uint32 i = 0; i < header->numPresets; i++)
+	{
+		uint64 offset = index[i].recordOffset;
+		if (offset % sizeof (double) != 0 || offset > size || size - offset < recordSize)
+		{
+			close ();
+			return false;
+		}
+	}
+	numPresets = (int32)header->numPresets;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void PresetBank::close ()
+{
+#if defined(_WIN32)
+	if (data)
+		UnmapViewOfFile (data);
+	if (mappingHandle)
+		CloseHandle ((HANDLE)mappingHandle);
+	if (fileHandle)
+		CloseHandle ((HANDLE)fileHandle);
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	if (data)
+		munmap ((void*)data, (size_t)size);
+#endif
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	index = nullptr;
+	numPresets = 0;
+}
+
+//-----------------------------------------------------------------------------
+std::string PresetBank::getName (int32 preset) const
+{
+	if (preset < 0 || preset >= numPresets)
+		return std::string ();
+	const char* name = index[preset].name;
+	return std::string (name, strnlen (name, kNameLength));
+}
+
+//-----------------------------------------------------------------------------
+bool PresetBank::write (const char* path, const char* const* names, const GlobalParameterState* states, int32 numPresets)
+{
+	BankHeader bankHeader = {};
+	memcpy (bankHeader.magic, kBankMagic, sizeof (kBankMagic));
+	bankHeader.bankVersion = kBankVersion;
+	bankHeader.paramVersion = GlobalParameterState::kStateVersion;
+	bankHeader.numValues = numValuesOfVersion (bankHeader.paramVersion);
+	bankHeader.numPresets = (uint32)numPresets;
+	bankHeader.indexOffset = sizeof (BankHeader);
+
+	std::vector<IndexEntry> entries (numPresets);
+	std::vector<double> records;
+	records.reserve ((size_t)numPresets * bankHeader.numValues);
+	uint64 recordBase = bankHeader.indexOffset + numPresets * sizeof (IndexEntry);
+	for (int32 i = 0; i < numPresets; i++)
+	{
+		memset (entries[i].name, 0, kNameLength);
+		strncpy (entries[i].name, names[i], kNameLength);
+		entries[i].recordOffset = recordBase + records.size () * sizeof (double);
+		for (const auto& desc : kParameterDescriptors)
+		{
+			if (desc.stateVersion != ParameterDescriptor::kNotStored)
+				records.push_back (desc.getNormalized (states[i]));
+		}
+	}
+
+	std::ofstream out (path, std::ios::binary | std::ios::trunc);
+	out.write ((const char*)&bankHeader, sizeof (bankHeader));
+	out.write ((const char*)entries.data (), (std::streamsize)(entries.size () * sizeof (IndexEntry)));
+	out.write ((const char*)records.data (), (std::streamsize)(records.size () * sizeof (double)));
+	return out.good ();
+}
+
+}}} // namespaces
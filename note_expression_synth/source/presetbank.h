@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/presetbank.h
+// Description : Memory mapped bank of presets with fixed size records
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "parameterdescriptors.h"
+#include <string>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+// IMessage from the controller to the processor, "path" holds the UTF-8 file path
+static constexpr const char* kPresetBankMessageID = "PresetBank";
+static constexpr const char* kPresetBankPathAttr = "path";
+
+//-----------------------------------------------------------------------------
+/** A read only bank file mapped into memory, nothing is parsed per preset.
+
+	Layout (little endian):
+		BankHeader
+		IndexEntry [numPresets]		name and offset of every record
+		records						numValues doubles each
+
+	A record holds the normalized value of every stored parameter of paramVersion, in the order
+	of kParameterDescriptors (the same fields getState writes). Applying preset k is one pass
+	over its record, so switching presets costs the same for a bank of 10 or 10000.
+
+	open validates the header and all record offsets and must not be called on the audio
+	thread, getPreset may be.
+*/
+class PresetBank
+{
+public:
+	enum
+	{
+		kBankVersion = 1,
+		kNameLength = 56
+	};
+
+	struct BankHeader
+	{
+		char magic[4];			// "NESB"
+		uint32 bankVersion;
+		uint32 paramVersion;	// GlobalParameterState version of the records
+		uint32 numValues;		// doubles per record
+		uint32 numPresets;
+		uint32 reserved;
+		uint64 indexOffset;
+	};
+
+	struct IndexEntry
+	{
+		char name[kNameLength];	// UTF-8, not terminated when it uses all kNameLength bytes
+		uint64 recordOffset;
+	};
+
+	PresetBank ();
+	~PresetBank ();
+
+	bool open (const char* path);
+	void close ();
+
+	int32 getNumPresets () const { return numPresets; }
+	std::string getName (int32 preset) const;
+
+	/** calls setValue (const ParameterDescriptor&, ParamValue normalized) for every parameter
+		stored in the preset, false when there is no such preset */
+	template<class Setter>
+	bool getPreset (int32 preset, Setter setValue) const;
+
+	/** writes a bank of the current state version */
+	static bool write (const char* path, const char* const* names, const GlobalParameterState* states, int32 numPresets);
+
+protected:
+	PresetBank (const PresetBank&) = delete;
+	PresetBank& operator= (const PresetBank&) = delete;
+
+	static uint32 numValuesOfVersion (uint32 paramVersion);
+
+	const char* data;
+	uint64 size;
+	const BankHeader* header;
+	const IndexEntry* index;
+	int32 numPresets;
+#if defined(_WIN32)
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
+
+//-----------------------------------------------------------------------------
+template<class Setter>
+inline bool PresetBank::getPreset (int32 preset, Setter setValue) const
+{
+	if (preset < 0 || preset >= numPresets)
+		return false;
+	const double* record = (const double*)(data + index[preset].recordOffset);
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (desc.stateVersion == ParameterDescriptor::kNotStored || (uint32)desc.stateVersion > header->paramVersion)
+			continue;
+		setValue (desc, *record++);
+	}
+	return true;
+}
+
+}}} // namespaces
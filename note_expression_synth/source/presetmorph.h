@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/presetmorph.h
+// Description : Crossfades the global parameters between two stored states
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "parameterdescriptors.h"
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Two resident GlobalParameterState slots (A and B) and the state between them.
+
+	apply writes every morphed field of the working state from the morph position: continuous
+	fields (kLinear, kBipolar) are interpolated, discrete fields (kStepped, kSwitch) take the
+	value of A below kSwitchPosition and of B from there on. The processor calls it for every
+	automation step of kParamMorph, so the voices follow a single lane at control rate.
+
+	Fields applied at setActive and the morph parameters themselves are not morphed. Nothing
+	here allocates, all methods may be called on the audio thread.
+*/
+class PresetMorph
+{
+public:
+	enum Slot
+	{
+		kSlotA,
+		kSlotB,
+		kNumSlots
+	};
+
+	static constexpr ParamValue kSwitchPosition = 0.5;
+
+	PresetMorph () {}
+
+	void store (Slot slot, const GlobalParameterState& state) { slots[slot] = state; }
+	const GlobalParameterState& getSlot (Slot slot) const { return slots[slot]; }
+	GlobalParameterState& getSlot (Slot slot) { return slots[slot]; }
+
+	/** returns the changedParameters bits of the fields it modified */
+	uint64 apply (ParamValue position, GlobalParameterState& state) const;
+
+	static bool isMorphed (const ParameterDescriptor& desc);
+
+protected:
+	GlobalParameterState slots[kNumSlots];
+};
+
+//-----------------------------------------------------------------------------
+inline bool PresetMorph::isMorphed (const ParameterDescriptor& desc)
+{
+	switch (desc.id)
+	{
+		case kParamMorph:
+		case kParamRenderThreads:
+		case kParamPolyphony:
+		case kParamHighPrecision:
+			return false;
+	}
+	return desc.transform != ParameterDescriptor::kNone && desc.transform != ParameterDescriptor::kTrigger;
+}
+
+//-----------------------------------------------------------------------------
+inline uint64 PresetMorph::apply (ParamValue position, GlobalParameterState& state) const
+{
+	const GlobalParameterState& a = slots[kSlotA];
+	const GlobalParameterState& b = slots[kSlotB];
+	const GlobalParameterState& nearest = position < kSwitchPosition ? a : b;
+	uint64 changed = 0;
+	for (const auto& desc : kParameterDescriptors)
+	{
+		if (!isMorphed (desc))
+			continue;
+		if (desc.value)
+		{
+			ParamValue value = a.*desc.value + position * (b.*desc.value - a.*desc.value);
+			if (state.*desc.value == value)
+				continue;
+			state.*desc.value = value;
+		}
+		else
+		{
+			if (state.*desc.step == nearest.*desc.step)
+				continue;
+			state.*desc.step = nearest.*desc.step;
+		}
+		changed |= (uint64)1 << desc.id;
+	}
+	return changed;
+}
+
+}}} // namespaces
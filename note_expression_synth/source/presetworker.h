@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/presetworker.h
+// Description : Saves and loads the parameter state on a worker thread for the audio thread
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "spscqueue.h"
+#include "public.sdk/source/common/memorystream.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Preset file I/O for the audio thread.
+
+	The audio thread posts a copy of its State with every request, the worker writes it with
+	State::getState or reads the file with State::setState on top of it (fields missing in an
+	older file keep their value). Loaded states come back through a second queue, the audio
+	thread fetches them at a block boundary.
+
+	The worker polls its queue every kPollInterval so the audio thread never has to take a lock
+	or wake it. start and stop create and join the thread, not from the audio thread.
+*/
+template<class State>
+class PresetWorker
+{
+public:
+	enum
+	{
+		kQueueSize = 4,			// requests beyond are dropped
+		kPollInterval = 10		// ms
+	};
+
+	PresetWorker () : quit (false) {}
+	~PresetWorker () { stop (); }
+
+	void start ()
+	{
+		if (thread.joinable ())
+			return;
+		quit = false;
+		thread = std::thread (&PresetWorker::workerLoop, this);
+	}
+
+	void stop ()
+	{
+		if (!thread.joinable ())
+			return;
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			quit = true;
+		}
+		wakeup.notify_all ();
+		thread.join ();
+		// results nobody fetches anymore
+		State state;
+		while (loaded.pop (state)) {}
+	}
+
+	/** the preset file, not from the audio thread */
+	void setPath (const std::string& newPath)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		path = newPath;
+	}
+
+	//--- audio thread, false when the request queue is full ---
+	bool requestSave (const State& state) { return requests.push ({kSave, state}); }
+	bool requestLoad (const State& state) { return requests.push ({kLoad, state}); }
+	/** a state read by an earlier requestLoad */
+	bool fetchLoaded (State& state) { return loaded.pop (state); }
+
+protected:
+	enum RequestType { kSave, kLoad };
+
+	struct Request
+	{
+		RequestType type;
+		State state;
+	};
+
+	void workerLoop ()
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		while (!quit)
+		{
+			Request request;
+			while (requests.pop (request))
+			{
+				std::string file = path;
+				lock.unlock ();
+				if (request.type == kSave)
+					save (file, request.state);
+				else if (load (file, request.state))
+					loaded.push (request.state);
+				lock.lock ();
+			}
+			wakeup.wait_for (lock, std::chrono::milliseconds (kPollInterval), [this] { return quit.load (); });
+		}
+	}
+
+	static bool save (const std::string& file, State& state)
+	{
+		MemoryStream stream;
+		if (state.getState (&stream) != kResultTrue)
+			return false;
+		std::ofstream out (file, std::ios::binary | std::ios::trunc);
+		out.write (stream.getData (), (std::streamsize)stream.getSize ());
+		return out.good ();
+	}
+
+	static bool load (const std::string& file, State& state)
+	{
+		std::ifstream in (file, std::ios::binary);
+		if (!in)
+			return false;
+		std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+		MemoryStream stream (&data[0], (TSize)data.size ());
+		return state.setState (&stream) == kResultTrue;
+	}
+
+	SpscQueue<Request, kQueueSize> requests;	// audio thread to worker
+	SpscQueue<State, kQueueSize> loaded;		// worker to audio thread
+	std::thread thread;
+	std::atomic<bool> quit;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::string path;	// mutex
+};
+
+}}} // namespaces
@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/renderpool.cpp
+// Description : Real-time worker threads rendering voices in parallel
+//
+//-----------------------------------------------------------------------------
+
+#include "renderpool.h"
+#include "denormals.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NOTE_EXPRESSION_SYNTH_CPU_PAUSE() _mm_pause ()
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define NOTE_EXPRESSION_SYNTH_CPU_PAUSE() __asm__ __volatile__ ("yield")
+#else
+#define NOTE_EXPRESSION_SYNTH_CPU_PAUSE()
+#endif
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** the scheduling class of an audio thread for the calling worker, without the rights for it
+	(no rtprio on Linux) the worker keeps its normal priority */
+static void setRealtimePriority (double periodSeconds)
+{
+#if defined(_WIN32)
+	(void)periodSeconds;
+	SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_TIME_CRITICAL);
+#elif defined(__APPLE__)
+	// the time constraint policy Core Audio gives its own I/O threads
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info (&timebase);
+	double ticksPerSecond = 1e9 * timebase.denom / timebase.numer;
+	double period = periodSeconds > 0. ? periodSeconds : 0.01;
+	thread_time_constraint_policy_data_t policy;
+	policy.period = (uint32_t)(period * ticksPerSecond);
+	policy.computation = (uint32_t)(period * 0.5 * ticksPerSecond);
+	policy.constraint = policy.period;
+	policy.preemptible = 1;
+	thread_policy_set (pthread_mach_thread_np (pthread_self ()), THREAD_TIME_CONSTRAINT_POLICY,
+	                   (thread_policy_t)&policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+#else
+	(void)periodSeconds;
+	// below the priority JACK and PipeWire give their audio threads
+	sched_param param {};
+	param.sched_priority = std::min (std::max (70, sched_get_priority_min (SCHED_FIFO)), sched_get_priority_max (SCHED_FIFO));
+	pthread_setschedparam (pthread_self (), SCHED_FIFO, &param);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+RenderPool::RenderPool ()
+: numThreads (0)
+, tasks (nullptr)
+, numWorkers (1)
+, generation (0)
+, openRun (0)
+, remaining (0)
+, active (0)
+, parked (0)
+, quit (false)
+{
+	for (int32 i = 0; i <= kMaxThreads; i++)
+	{
+		chunks[i].next = 0;
+		chunks[i].end = 0;
+		stats[i].nanos = 0;
+		stats[i].tasks = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+RenderPool::~RenderPool ()
+{
+	stop ();
+}
+
+//-----------------------------------------------------------------------------
+void RenderPool::start (int32 _numThreads, double periodSeconds)
+{
+	stop ();
+	numThreads = std::min<int32> (std::max<int32> (_numThreads, 0), kMaxThreads);
+	quit = false;
+	threads.reserve (numThreads);
+	for (int32 i = 0; i < numThreads; i++)
+		threads.emplace_back (&RenderPool::workerLoop, this, i + 1, generation.load (), periodSeconds);
+}
+
+//-----------------------------------------------------------------------------
+void RenderPool::stop ()
+{
+	if (threads.empty ())
+		return;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		quit = true;
+	}
+	wakeup.notify_all ();
+	for (auto& thread : threads)
+		thread.join ();
+	threads.clear ();
+	numThreads = 0;
+}
+
+//-----------------------------------------------------------------------------
+void RenderPool::run (IRenderTasks* _tasks, int32 numTasks, const int32* chunkEnds)
+{
+	tasks = _tasks;
+	numWorkers = numThreads + 1;
+	int32 begin = 0;
+	for (int32 i = 0; i < numWorkers; i++)
+	{
+		int32 end = chunkEnds ? chunkEnds[i] : numTasks * (i + 1) / numWorkers;
+		chunks[i].next.store (begin, std::memory_order_relaxed);
+		chunks[i].end = end;
+		begin = end;
+		// a worker which sits this run out reports nothing
+		stats[i].nanos.store (0, std::memory_order_relaxed);
+		stats[i].tasks.store (0, std::memory_order_relaxed);
+	}
+	remaining.store (numTasks, std::memory_order_relaxed);
+
+	if (numThreads == 0)
+	{
+		work (0);
+		return;
+	}
+
+	uint32 thisRun = generation.load (std::memory_order_relaxed) + 1;
+	openRun.store (thisRun);
+	generation.store (thisRun, std::memory_order_release);
+	// only parked workers need the lock, spinning ones see the generation change
+	if (parked.load () > 0)
+	{
+		{ std::lock_guard<std::mutex> lock (mutex); }
+		wakeup.notify_all ();
+	}
+
+	work (0);
+
+	// only tasks a worker has taken are waited for, not workers which have not woken yet
+	while (remaining.load (std::memory_order_acquire) > 0)
+		NOTE_EXPRESSION_SYNTH_CPU_PAUSE ();
+
+	// close the run, a worker joining from now on leaves without touching the chunks. Those
+	// which joined before are at most scanning the empty chunks.
+	openRun.store (thisRun - 1);
+	while (active.load () > 0)
+		NOTE_EXPRESSION_SYNTH_CPU_PAUSE ();
+}
+
+//-----------------------------------------------------------------------------
+int64 RenderPool::getWorkerNanos (int32 worker) const
+{
+	return (worker >= 0 && worker <= kMaxThreads) ? stats[worker].nanos.load (std::memory_order_relaxed) : 0;
+}
+
+//-----------------------------------------------------------------------------
+int32 RenderPool::getWorkerTasks (int32 worker) const
+{
+	return (worker >= 0 && worker <= kMaxThreads) ? stats[worker].tasks.load (std::memory_order_relaxed) : 0;
+}
+
+//-----------------------------------------------------------------------------
+void RenderPool::workerLoop (int32 worker, uint32 seen, double periodSeconds)
+{
+	setRealtimePriority (periodSeconds);
+	// the FP mode is per thread, the one the audio thread sets in process does not reach here
+	ScopedFlushDenormals flushDenormals;
+
+	while (true)
+	{
+		uint32 current = generation.load (std::memory_order_acquire);
+		for (int32 i = 0; current == seen && i < kSpinCount; i++)
+		{
+			NOTE_EXPRESSION_SYNTH_CPU_PAUSE ();
+			current = generation.load (std::memory_order_acquire);
+		}
+		if (current == seen)
+		{
+			std::unique_lock<std::mutex> lock (mutex);
+			parked++;
+			wakeup.wait (lock, [&] { return quit.load () || generation.load () != seen; });
+			parked--;
+			current = generation.load (std::memory_order_acquire);
+		}
+		if (quit.load ())
+			break;
+
+		seen = current;
+		// the run may have been closed while this worker was waking up
+		active.fetch_add (1);
+		if (openRun.load () == current)
+			work (worker);
+		active.fetch_sub (1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void RenderPool::work (int32 worker)
+{
+	auto startTime = std::chrono::steady_clock::now ();
+	int32 numTasksRun = 0;
+
+	// own chunk first, then steal from the following ones
+	for (int32 i = 0; i < numWorkers; i++)
+	{
+		Chunk& chunk = chunks[(worker + i) % numWorkers];
+		int32 task;
+		while ((task = chunk.next.fetch_add (1, std::memory_order_relaxed)) < chunk.end)
+		{
+			tasks->runTask (task);
+			numTasksRun++;
+		}
+	}
+
+	auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - startTime);
+	stats[worker].nanos.store ((int64)nanos.count (), std::memory_order_relaxed);
+	stats[worker].tasks.store (numTasksRun, std::memory_order_relaxed);
+	if (numTasksRun > 0)
+		remaining.fetch_sub (numTasksRun, std::memory_order_release);
+}
+
+}}} // namespaces
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/renderpool.h
+// Description : Real-time worker threads rendering voices in parallel
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+class IRenderTasks
+{
+public:
+	virtual ~IRenderTasks () {}
+
+	/** called once per task index, from any thread of the pool */
+	virtual void runTask (int32 task) = 0;
+};
+
+//-----------------------------------------------------------------------------
+/** Real-time worker threads for the audio thread.
+
+	run splits the task indices into one chunk per thread (the calling thread takes part as
+	worker 0). A thread first takes the tasks of its own chunk and then steals from the other
+	chunks, every chunk is a shared atomic cursor so nothing is taken twice.
+
+	run returns as soon as every task is finished: the chunk of a worker the OS has not woken
+	in time is stolen by the others and the late worker leaves the run without touching it.
+	The workers run at the priority of audio threads with FTZ/DAZ set and are not tied to cores,
+	so many plugin instances spread over the machine.
+
+	Idle workers spin for a while after a run and then park on a condition variable, the next
+	run only takes the lock when one of them is parked. start and stop create and join the
+	threads and must not be called from the audio thread, run never allocates.
+*/
+class RenderPool
+{
+public:
+	enum
+	{
+		kMaxThreads = 32,		// besides the calling thread
+		kSpinCount = 20000		// polls before a worker parks
+	};
+
+	RenderPool ();
+	~RenderPool ();
+
+	/** starts numThreads workers (0 renders everything on the calling thread), periodSeconds
+		is the duration of a host block, the deadline the scheduler is told about */
+	void start (int32 numThreads, double periodSeconds);
+	void stop ();
+
+	int32 getNumThreads () const { return numThreads; }
+
+	int32 getNumWorkers () const { return numThreads + 1; }
+
+	/** runs tasks [0, numTasks) and returns when all of them are done. chunkEnds may give the
+		end of every worker's chunk (getNumWorkers entries, the last one numTasks), otherwise
+		the tasks are split evenly. */
+	void run (IRenderTasks* tasks, int32 numTasks, const int32* chunkEnds = nullptr);
+
+	/** time the worker spent in the last run and how many tasks it took (0 when it did not
+		wake in time), 0 is the calling thread. May be read from any thread. */
+	int64 getWorkerNanos (int32 worker) const;
+	int32 getWorkerTasks (int32 worker) const;
+	/** counts the runs with workers, the stats are from the current block when it moved */
+	uint32 getNumRuns () const { return generation.load (std::memory_order_relaxed); }
+
+protected:
+	// one cache line each (padded, alignas would need an aligned new for the Processor)
+	struct Chunk
+	{
+		std::atomic<int32> next;
+		int32 end;
+		char padding[64 - 2 * sizeof (int32)];
+	};
+
+	struct WorkerStats
+	{
+		std::atomic<int64> nanos;
+		std::atomic<int32> tasks;
+		char padding[64 - sizeof (int64) - sizeof (int32)];
+	};
+
+	void workerLoop (int32 worker, uint32 seen, double periodSeconds);
+	void work (int32 worker);
+
+	std::vector<std::thread> threads;
+	int32 numThreads;
+
+	IRenderTasks* tasks;
+	int32 numWorkers;		// chunks of the current run
+	Chunk chunks[kMaxThreads + 1];
+	WorkerStats stats[kMaxThreads + 1];
+
+	std::atomic<uint32> generation;
+	std::atomic<uint32> openRun;	// generation workers may still join
+	std::atomic<int32> remaining;	// tasks of the current run not finished yet
+	std::atomic<int32> active;		// workers inside the current run
+	std::atomic<int32> parked;
+	std::atomic<bool> quit;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+};
+
+}}} // namespaces
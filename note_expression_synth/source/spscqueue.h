@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/spscqueue.h
+// Description : Bounded lock-free queue between exactly one producer and one consumer
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <atomic>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Ring buffer of capacity items (a power of two) which never allocates or blocks.
+
+	push is only called by the producer thread and pop by the consumer thread, so either side
+	can be the audio thread. The cursors count up and wrap as unsigned integers.
+*/
+template<class T, uint32 capacity>
+class SpscQueue
+{
+public:
+	static_assert (capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+	SpscQueue () : head (0), tail (0) {}
+
+	/** producer: false when the queue is full */
+	bool push (const T& item)
+	{
+		uint32 h = head.load (std::memory_order_relaxed);
+		if (h - tail.load (std::memory_order_acquire) == capacity)
+			return false;
+		items[h & (capacity - 1)] = item;
+		head.store (h + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** consumer: false when the queue is empty */
+	bool pop (T& item)
+	{
+		uint32 t = tail.load (std::memory_order_relaxed);
+		if (head.load (std::memory_order_acquire) == t)
+			return false;
+		item = items[t & (capacity - 1)];
+		tail.store (t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** either side, only a hint while the other side is running */
+	bool empty () const
+	{
+		return head.load (std::memory_order_acquire) == tail.load (std::memory_order_acquire);
+	}
+
+protected:
+	// producer and consumer cursors on their own cache lines
+	std::atomic<uint32> head;
+	char headPadding[64 - sizeof (uint32)];
+	std::atomic<uint32> tail;
+	char tailPadding[64 - sizeof (uint32)];
+	T items[capacity];
+};
+
+}}} // namespaces
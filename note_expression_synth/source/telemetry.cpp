@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/telemetry.cpp
+// Description : Meter values from the audio thread to the editor, without the host
+//
+//-----------------------------------------------------------------------------
+
+#include "telemetry.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+void TelemetryRecord::coalesce (const TelemetryRecord& newer)
+{
+	// a meter must not miss the loudest block between two frames
+	float heldPeak[kNumChannels];
+	for (int32 c = 0; c < kNumChannels; c++)
+		heldPeak[c] = std::max (peak[c], newer.peak[c]);
+	*this = newer;
+	for (int32 c = 0; c < kNumChannels; c++)
+		peak[c] = heldPeak[c];
+}
+
+//-----------------------------------------------------------------------------
+bool TelemetryChannel::drain (TelemetryRecord& latest)
+{
+	TelemetryRecord record;
+	if (!queue.pop (record))
+		return false;
+	latest = record;
+	while (queue.pop (record))
+		latest.coalesce (record);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// shared by every processor and controller of the factory, each entry holds a reference
+static std::mutex registryMutex;
+static std::map<int64, TelemetryChannel*> registry;
+static int64 lastKey = 0;
+
+//-----------------------------------------------------------------------------
+int64 TelemetryChannel::announce (TelemetryChannel* channel)
+{
+	std::lock_guard<std::mutex> lock (registryMutex);
+	channel->addRef ();
+	registry[++lastKey] = channel;
+	return lastKey;
+}
+
+//-----------------------------------------------------------------------------
+void TelemetryChannel::withdraw (int64 key)
+{
+	TelemetryChannel* channel = nullptr;
+	{
+		std::lock_guard<std::mutex> lock (registryMutex);
+		auto it = registry.find (key);
+		if (it == registry.end ())
+			return;
+		channel = it->second;
+		registry.erase (it);
+	}
+	channel->release ();
+}
+
+//-----------------------------------------------------------------------------
+IPtr<TelemetryChannel> TelemetryChannel::find (int64 key)
+{
+	std::lock_guard<std::mutex> lock (registryMutex);
+	auto it = registry.find (key);
+	if (it == registry.end ())
+		return nullptr;
+	return it->second;
+}
+
+//-----------------------------------------------------------------------------
+int64 TelemetryChannel::getProcessId ()
+{
+#if defined(_WIN32)
+	return (int64)GetCurrentProcessId ();
+#else
+	return (int64)getpid ();
+#endif
+}
+
+}}} // namespaces
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/telemetry.h
+// Description : Meter values from the audio thread to the editor, without the host
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "spscqueue.h"
+#include "pluginterfaces/base/smartpointer.h"
+#include <atomic>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+// IMessage from the processor to the controller when they connect, the attributes hold the
+// key the TelemetryChannel is announced with and the id of the process it lives in
+static constexpr const char* kTelemetryMessageID = "Telemetry";
+static constexpr const char* kTelemetryKeyAttr = "key";
+static constexpr const char* kTelemetryProcessAttr = "process";
+
+//-----------------------------------------------------------------------------
+/** What the processor measured in one block. */
+struct TelemetryRecord
+{
+	enum
+	{
+		kNumChannels = 2,
+		kMaxVoiceLevels = 32,	// voices beyond are counted but not listed
+		kMaxWorkers = 33		// RenderPool::kMaxThreads and the audio thread
+	};
+
+	float peak[kNumChannels];	// of the output bus, linear
+	float rms[kNumChannels];
+	float renderTime;			// seconds spent in process
+	float renderLoad;			// renderTime / block duration
+	int32 activeVoices;
+	int32 numVoiceLevels;
+	float voiceLevels[kMaxVoiceLevels];	// envelope of the playing voices, [0, 1]
+	int32 numWorkers;			// 0 when the block was rendered without the RenderPool
+	float workerLoad[kMaxWorkers];		// time in the run / block duration, 0 is the audio thread
+	int32 workerTasks[kMaxWorkers];		// voices the worker rendered
+
+	/** folds a newer record into this one: peaks are held, everything else is replaced */
+	void coalesce (const TelemetryRecord& newer);
+};
+
+//-----------------------------------------------------------------------------
+/** One TelemetryRecord per block from the audio thread to the editor.
+
+	The processor creates the channel and pushes a record after every block, records are dropped
+	while nobody drains them (no editor open). The controller takes a reference when the
+	processor announces it and drains the queue from a UI timer, so meters never go through
+	the parameter system of the host.
+
+	Both sides hold an IPtr, the channel lives until the later of them releases it. The
+	processor announces the channel in a registry of the process while it is connected and
+	sends only the key, the controller looks it up. A message the host delivers after the
+	processor disconnected finds nothing instead of a freed channel. Keys are only unique within
+	a process, the controller checks the process id as well.
+*/
+class TelemetryChannel
+{
+public:
+	enum
+	{
+		kQueueSize = 64	// blocks, more than a display frame at small block sizes
+	};
+
+	TelemetryChannel () : refCount (1) {}
+
+	uint32 addRef () { return ++refCount; }
+	uint32 release ()
+	{
+		uint32 count = --refCount;
+		if (count == 0)
+			delete this;
+		return count;
+	}
+
+	/** audio thread: false when the editor has not drained the queue */
+	bool push (const TelemetryRecord& record) { return queue.push (record); }
+	/** UI thread: coalesces every pending record into latest, false when there was none */
+	bool drain (TelemetryRecord& latest);
+
+	/** registers the channel until withdraw, keys are never reused within the process */
+	static int64 announce (TelemetryChannel* channel);
+	static void withdraw (int64 key);
+	/** the channel announced with key, nullptr once it was withdrawn */
+	static IPtr<TelemetryChannel> find (int64 key);
+
+	static int64 getProcessId ();
+
+protected:
+	~TelemetryChannel () {}
+
+	std::atomic<uint32> refCount;
+	SpscQueue<TelemetryRecord, kQueueSize> queue;
+};
+
+}}} // namespaces
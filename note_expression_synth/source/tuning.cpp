@@ -0,0 +1,227 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/tuning.cpp
+// Description : Scala scales and keyboard mappings turned into per note phase increments
+//
+//-----------------------------------------------------------------------------
+
+#include "tuning.h"
+#include "voicetables.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** the lines of a Scala file without the '!' comments */
+static std::vector<std::string> scalaLines (const char* text, int32 size)
+{
+	std::vector<std::string> lines;
+	std::istringstream stream (std::string (text, size));
+	std::string line;
+	while (std::getline (stream, line))
+	{
+		if (!line.empty () && line.back () == '\r')
+			line.pop_back ();
+		if (!line.empty () && line[0] == '!')
+			continue;
+		lines.push_back (line);
+	}
+	return lines;
+}
+
+//-----------------------------------------------------------------------------
+static bool parseInt (const std::string& line, int32& value)
+{
+	char* end = nullptr;
+	long result = strtol (line.c_str (), &end, 10);
+	if (end == line.c_str ())
+		return false;
+	value = (int32)result;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+/** a pitch line: cents when it has a period, otherwise a ratio a/b or a plain integer */
+static bool parsePitch (const std::string& line, double& ratio)
+{
+	size_t begin = line.find_first_not_of (" \t");
+	if (begin == std::string::npos)
+		return false;
+	size_t end = line.find_first_of (" \t", begin);
+	std::string token = line.substr (begin, end == std::string::npos ? std::string::npos : end - begin);
+
+	if (token.find ('.') != std::string::npos)
+	{
+		char* tail = nullptr;
+		double cents = strtod (token.c_str (), &tail);
+		if (tail == token.c_str ())
+			return false;
+		ratio = std::pow (2., cents / 1200.);
+		return true;
+	}
+
+	char* tail = nullptr;
+	double numerator = (double)strtoll (token.c_str (), &tail, 10);
+	if (tail == token.c_str ())
+		return false;
+	double denominator = 1.;
+	if (*tail == '/')
+	{
+		const char* denominatorText = tail + 1;
+		denominator = (double)strtoll (denominatorText, &tail, 10);
+		if (tail == denominatorText)
+			return false;
+	}
+	if (numerator <= 0. || denominator <= 0.)
+		return false;
+	ratio = numerator / denominator;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+Tuning::Tuning ()
+{
+	reset ();
+}
+
+//-----------------------------------------------------------------------------
+void Tuning::reset ()
+{
+	ratios.clear ();
+	for (int32 i = 1; i <= 12; i++)
+		ratios.push_back (std::pow (2., i / 12.));
+	parseKeyboardMapping ("", 0);
+}
+
+//-----------------------------------------------------------------------------
+bool Tuning::parseScale (const char* text, int32 size)
+{
+	std::vector<std::string> lines = scalaLines (text, size);
+	// line 0 is the description, it may be empty
+	int32 count = 0;
+	if (lines.size () < 2 || !parseInt (lines[1], count) || count < 1 || (int32)lines.size () < 2 + count)
+		return false;
+
+	std::vector<double> result;
+	for (int32 i = 0; i < count; i++)
+	{
+		double ratio;
+		if (!parsePitch (lines[2 + i], ratio))
+			return false;
+		result.push_back (ratio);
+	}
+	ratios.swap (result);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Tuning::parseKeyboardMapping (const char* text, int32 size)
+{
+	KeyboardMapping result;
+	result.size = 0;
+	result.firstNote = 0;
+	result.lastNote = TuningTable::kNumNotes - 1;
+	result.middleNote = 60;
+	result.referenceNote = 69;
+	result.referenceFrequency = 440.;
+	result.octaveDegree = 0;	// unused by the linear mapping
+
+	if (size > 0)
+	{
+		std::vector<std::string> lines = scalaLines (text, size);
+		// skip blank lines, the entries of a .kbm file are never empty
+		lines.erase (std::remove_if (lines.begin (), lines.end (), [] (const std::string& line) {
+			             return line.find_first_not_of (" \t") == std::string::npos;
+		             }),
+		             lines.end ());
+		if (lines.size () < 7)
+			return false;
+		char* tail = nullptr;
+		if (!parseInt (lines[0], result.size) || !parseInt (lines[1], result.firstNote) ||
+		    !parseInt (lines[2], result.lastNote) || !parseInt (lines[3], result.middleNote) ||
+		    !parseInt (lines[4], result.referenceNote) || !parseInt (lines[6], result.octaveDegree))
+			return false;
+		result.referenceFrequency = strtod (lines[5].c_str (), &tail);
+		// in size_t, a huge map size must not wrap around the line count
+		if (tail == lines[5].c_str () || result.referenceFrequency <= 0. || result.size < 0 ||
+		    (size_t)result.size > lines.size () - 7 || result.octaveDegree < 0)
+			return false;
+		// the linear mapping has no degree lines
+		if (result.size == 0 && lines.size () > 7)
+			return false;
+		for (int32 i = 0; i < result.size; i++)
+		{
+			int32 degree = -1;
+			if (lines[7 + i].find ('x') == std::string::npos && !parseInt (lines[7 + i], degree))
+				return false;
+			result.degrees.push_back (degree);
+		}
+	}
+	mapping = result;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+double Tuning::degreeRatio (int32 degree) const
+{
+	int32 numDegrees = (int32)ratios.size ();
+	int32 octave = degree >= 0 ? degree / numDegrees : -((-degree + numDegrees - 1) / numDegrees);
+	int32 index = degree - octave * numDegrees;
+	double ratio = index == 0 ? 1. : ratios[index - 1];
+	return ratio * std::pow (ratios.back (), octave);
+}
+
+//-----------------------------------------------------------------------------
+bool Tuning::keyRatio (int32 key, double& ratio) const
+{
+	if (key < mapping.firstNote || key > mapping.lastNote)
+		return false;
+	int32 offset = key - mapping.middleNote;
+	if (mapping.size == 0)
+	{
+		ratio = degreeRatio (offset);
+		return true;
+	}
+	int32 repeats = offset >= 0 ? offset / mapping.size : -((-offset + mapping.size - 1) / mapping.size);
+	int32 degree = mapping.degrees[offset - repeats * mapping.size];
+	if (degree < 0)
+		return false;
+	ratio = degreeRatio (degree) * std::pow (degreeRatio (mapping.octaveDegree), repeats);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void Tuning::getFrequencies (double frequencies[TuningTable::kNumNotes]) const
+{
+	double referenceRatio;
+	bool mapped = keyRatio (mapping.referenceNote, referenceRatio) && referenceRatio > 0.;
+	for (int32 key = 0; key < TuningTable::kNumNotes; key++)
+	{
+		double ratio;
+		if (mapped && keyRatio (key, ratio))
+			frequencies[key] = mapping.referenceFrequency * ratio / referenceRatio;
+		else
+			frequencies[key] = VoiceTables::noteFrequency (key);
+	}
+}
+
+//-----------------------------------------------------------------------------
+TuningTable* Tuning::createTable (double sampleRate) const
+{
+	TuningTable* table = new TuningTable;
+	table->sampleRate = sampleRate;
+	table->radiansPerHz = 6.28318530717958647692 / sampleRate;
+	getFrequencies (table->frequencies);
+	for (int32 key = 0; key < TuningTable::kNumNotes; key++)
+		table->increments[key] = table->frequencies[key] * table->radiansPerHz;
+	return table;
+}
+
+}}} // namespaces
@@ -0,0 +1,85 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/tuning.h
+// Description : Scala scales and keyboard mappings turned into per note phase increments
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include "pointerexchange.h"
+#include <string>
+#include <vector>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+// IMessage from the controller to the processor, the attributes hold the file contents
+static constexpr const char* kTuningMessageID = "Tuning";
+static constexpr const char* kTuningScaleAttr = "scl";
+static constexpr const char* kTuningKeyboardMappingAttr = "kbm";	// optional
+
+//-----------------------------------------------------------------------------
+/** What the voices read: the frequency and the phase increment of every MIDI note at one
+	sample rate. Immutable once published. */
+struct TuningTable
+{
+	enum { kNumNotes = 128 };
+
+	double sampleRate;
+	double radiansPerHz;				// 2 pi / sampleRate
+	double frequencies[kNumNotes];		// Hz
+	double increments[kNumNotes];		// radians per sample
+};
+
+//-----------------------------------------------------------------------------
+/** A Scala scale (.scl) with its keyboard mapping (.kbm), 12-TET with A4 = 440 Hz by default.
+
+	Parsing allocates and must not happen on the audio thread. Keys the mapping leaves out
+	('x' entries or outside first/last note) keep their 12-TET frequency.
+*/
+class Tuning
+{
+public:
+	Tuning ();
+
+	/** the text of a .scl file, false (and the tuning unchanged) when it is malformed */
+	bool parseScale (const char* text, int32 size);
+	/** the text of a .kbm file, an empty text resets to the linear mapping */
+	bool parseKeyboardMapping (const char* text, int32 size);
+	void reset ();
+
+	void getFrequencies (double frequencies[TuningTable::kNumNotes]) const;
+	TuningTable* createTable (double sampleRate) const;
+
+protected:
+	struct KeyboardMapping
+	{
+		int32 size;			// 0: every key is the next scale degree
+		int32 firstNote;
+		int32 lastNote;
+		int32 middleNote;	// key of scale degree 0
+		int32 referenceNote;
+		double referenceFrequency;
+		int32 octaveDegree;	// degree the mapping repeats at, size > 0 only
+		std::vector<int32> degrees;	// -1 for unmapped keys
+	};
+
+	/** ratio of any scale degree, the last ratio of the scale is the period */
+	double degreeRatio (int32 degree) const;
+	/** ratio of the key relative to degree 0, false for unmapped keys */
+	bool keyRatio (int32 key, double& ratio) const;
+
+	std::vector<double> ratios;	// degrees 1 to n
+	KeyboardMapping mapping;
+};
+
+//-----------------------------------------------------------------------------
+typedef PointerExchange<TuningTable> TuningTableExchange;
+
+}}} // namespaces
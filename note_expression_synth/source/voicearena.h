@@ -0,0 +1,85 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/voicearena.h
+// Description : One cache line aligned allocation for all voices and their buffers
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <cstdlib>
+#include <new>
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Holds numVoices voices back to back, each starting on a cache line, followed by their
+	VoiceClass::Buffers.
+
+	Walking the voices (note lookup, the governor, the render list) only touches their control
+	state, the large sample buffers are reached through Voice::buffers when a voice renders.
+	Allocates in the constructor, so it is created at setActive and never while processing.
+*/
+template<class VoiceClass>
+class VoiceArena
+{
+public:
+	enum { kCacheLine = 64 };
+
+	typedef typename VoiceClass::Buffers Buffers;
+
+	explicit VoiceArena (int32 numVoices)
+	: numVoices (numVoices)
+	, voiceStride (roundUp (sizeof (VoiceClass)))
+	, buffersStride (roundUp (sizeof (Buffers)))
+	{
+		memory = (char*)malloc (numVoices * (voiceStride + buffersStride) + kCacheLine);
+		if (memory == nullptr)
+			throw std::bad_alloc ();
+		char* aligned = (char*)roundUp ((size_t)memory);
+		voiceBase = aligned;
+		buffersBase = aligned + numVoices * voiceStride;
+		for (int32 i = 0; i < numVoices; i++)
+		{
+			Buffers* buffers = new (buffersBase + i * buffersStride) Buffers ();
+			VoiceClass* voice = new (voiceBase + i * voiceStride) VoiceClass ();
+			voice->setBuffers (buffers);
+		}
+	}
+
+	~VoiceArena ()
+	{
+		for (int32 i = 0; i < numVoices; i++)
+		{
+			(*this)[i].~VoiceClass ();
+			((Buffers*)(buffersBase + i * buffersStride))->~Buffers ();
+		}
+		free (memory);
+	}
+
+	int32 size () const { return numVoices; }
+
+	VoiceClass& operator[] (int32 index) { return *(VoiceClass*)(voiceBase + index * voiceStride); }
+	const VoiceClass& operator[] (int32 index) const { return *(const VoiceClass*)(voiceBase + index * voiceStride); }
+	int32 indexOf (const VoiceClass& voice) const { return (int32)(((const char*)&voice - voiceBase) / voiceStride); }
+
+protected:
+	VoiceArena (const VoiceArena&) = delete;
+	VoiceArena& operator= (const VoiceArena&) = delete;
+
+	static size_t roundUp (size_t size) { return (size + kCacheLine - 1) & ~(size_t)(kCacheLine - 1); }
+
+	int32 numVoices;
+	size_t voiceStride;
+	size_t buffersStride;
+	char* memory;
+	char* voiceBase;
+	char* buffersBase;
+};
+
+}}} // namespaces
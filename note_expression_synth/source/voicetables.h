@@ -0,0 +1,213 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/source/voicetables.h
+// Description : Note frequency, level and time factor tables built by the compiler
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+
+namespace Steinberg {
+namespace Vst {
+namespace NoteExpressionSynth {
+
+//-----------------------------------------------------------------------------
+/** Lookup tables of the voice, evaluated at compile time so nothing is computed at load.
+
+	kFrequencies:  12-TET note frequencies, A4 (note 69) = 440 Hz, exact to double precision
+	kLevelGain:    the VoiceStatics::normalizedLevel2Gain curve over [0, 1], linear interpolation
+	kTimeFactor:   100^x over [-1, +1] for the envelope time modulation, relative error < 5e-5
+*/
+namespace VoiceTables {
+
+//-----------------------------------------------------------------------------
+/** constexpr exp2/log2/pow, only meant for building the tables (slow, but exact to about
+	1e-15). FastMath is the one to use at run time. */
+namespace Math {
+
+static constexpr double kLn2 = 0.69314718055994530942;
+static constexpr double kLog2E = 1.4426950408889634074;
+
+//-----------------------------------------------------------------------------
+constexpr double exp2 (double x)
+{
+	// 2^x = 2^i * e^(f ln2), f in [0, 1)
+	double scale = 1.;
+	while (x >= 1.)
+	{
+		scale *= 2.;
+		x -= 1.;
+	}
+	while (x < 0.)
+	{
+		scale *= 0.5;
+		x += 1.;
+	}
+	double y = x * kLn2;
+	double term = 1.;
+	double sum = 1.;
+	for (int32 k = 1; k < 20; k++)
+	{
+		term *= y / k;
+		sum += term;
+	}
+	return sum * scale;
+}
+
+//-----------------------------------------------------------------------------
+constexpr double log2 (double x)
+{
+	// x = 2^e * m, m in [1, 2): ln (m) = 2 atanh (s), s = (m - 1) / (m + 1) < 1/3
+	double e = 0.;
+	while (x >= 2.)
+	{
+		x *= 0.5;
+		e += 1.;
+	}
+	while (x < 1.)
+	{
+		x *= 2.;
+		e -= 1.;
+	}
+	double s = (x - 1.) / (x + 1.);
+	double s2 = s * s;
+	double term = s;
+	double sum = 0.;
+	for (int32 k = 1; k < 40; k += 2)
+	{
+		sum += term / k;
+		term *= s2;
+	}
+	return e + 2. * sum * kLog2E;
+}
+
+//-----------------------------------------------------------------------------
+constexpr double pow (double x, double y)
+{
+	return x <= 0. ? 0. : exp2 (y * log2 (x));
+}
+
+} // Math
+
+//-----------------------------------------------------------------------------
+template<int32 numValues>
+struct Table
+{
+	enum { kSize = numValues };
+
+	double values[numValues];
+
+	constexpr double operator[] (int32 index) const { return values[index]; }
+
+	/** position in [0, numValues - 1], clamped */
+	double interpolate (double position) const
+	{
+		if (position <= 0.)
+			return values[0];
+		if (position >= numValues - 1)
+			return values[numValues - 1];
+		int32 index = (int32)position;
+		double frac = position - index;
+		return values[index] + (values[index + 1] - values[index]) * frac;
+	}
+};
+
+//-----------------------------------------------------------------------------
+static constexpr int32 kNumNotes = 128;
+static constexpr int32 kLevelGainSize = 1025;
+static constexpr int32 kTimeFactorSize = 513;
+
+static constexpr double kHeadRoom = 0.70710678118654752440 / 3.98107170553497250771; // 12 dB head room
+static constexpr double kLevelGainC1 = kHeadRoom * 15.848931924611134852; // +24 dB
+static constexpr double kLevelGainC2 = 24. / 20. / 0.30102999566398119521; // 24 dB / log10 (2)
+
+//-----------------------------------------------------------------------------
+constexpr Table<kNumNotes> makeFrequencies ()
+{
+	// the semitone ratios as literals, so no error accumulates over the octaves
+	constexpr double semitones[12] = {
+		1.,
+		1.0594630943592952646,
+		1.1224620483093729814,
+		1.1892071150027210667,
+		1.2599210498948731648,
+		1.3348398541700343648,
+		1.4142135623730950488,
+		1.4983070768766814988,
+		1.5874010519681994748,
+		1.6817928305074290861,
+		1.7817974362806786095,
+		1.8877486253633869933,
+	};
+	Table<kNumNotes> table {};
+	for (int32 note = 0; note < kNumNotes; note++)
+	{
+		int32 fromA = note + 3; // semitones above 6.875 Hz, the A six octaves below A4
+		double octave = 440. / 64.;
+		for (int32 i = 0; i < fromA / 12; i++)
+			octave *= 2.;
+		table.values[note] = octave * semitones[fromA % 12];
+	}
+	return table;
+}
+
+//-----------------------------------------------------------------------------
+constexpr Table<kLevelGainSize> makeLevelGain ()
+{
+	Table<kLevelGainSize> table {};
+	for (int32 i = 0; i < kLevelGainSize; i++)
+	{
+		double normalized = (double)i / (kLevelGainSize - 1);
+		if (normalized >= 0.5)
+			table.values[i] = kHeadRoom * Math::exp2 ((normalized - 0.5) * 24. / 20. / 0.30102999566398119521);
+		else
+			table.values[i] = kLevelGainC1 * Math::pow (normalized, kLevelGainC2);
+	}
+	return table;
+}
+
+//-----------------------------------------------------------------------------
+constexpr Table<kTimeFactorSize> makeTimeFactor ()
+{
+	Table<kTimeFactorSize> table {};
+	for (int32 i = 0; i < kTimeFactorSize; i++)
+		table.values[i] = Math::exp2 ((2. * i / (kTimeFactorSize - 1) - 1.) * 6.6438561897747246957); // log2 (100)
+	return table;
+}
+
+//-----------------------------------------------------------------------------
+static constexpr Table<kNumNotes> kFrequencies = makeFrequencies ();
+static constexpr Table<kLevelGainSize> kLevelGain = makeLevelGain ();
+static constexpr Table<kTimeFactorSize> kTimeFactor = makeTimeFactor ();
+
+static_assert (kFrequencies[69] == 440., "A4 is 440 Hz");
+static_assert (kFrequencies[81] == 880., "octaves are exact");
+
+//-----------------------------------------------------------------------------
+/** Hz of a MIDI note */
+inline double noteFrequency (int32 note)
+{
+	return kFrequencies[note];
+}
+
+//-----------------------------------------------------------------------------
+/** normalized level [0, 1] to gain */
+inline double levelGain (double normalized)
+{
+	return kLevelGain.interpolate (normalized * (kLevelGainSize - 1));
+}
+
+//-----------------------------------------------------------------------------
+/** 100^x for x in [-1, +1] */
+inline double timeFactor (double x)
+{
+	return kTimeFactor.interpolate ((x + 1.) * 0.5 * (kTimeFactorSize - 1));
+}
+
+} // VoiceTables
+
+}}} // namespaces
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/test/fastmath_test.cpp
+// Description : Checks the FastMath approximations against the standard library
+//
+//-----------------------------------------------------------------------------
+
+#include "../source/fastmath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst::NoteExpressionSynth;
+
+//-----------------------------------------------------------------------------
+// the error bounds documented in fastmath.h, in the units the voice cares about
+static const double kMaxPitchCents = 0.001;
+static const double kMaxGainDb = 1e-5;
+static const double kMaxLog2Error = 2e-9;
+static const double kMaxSinError = 2e-4;
+static const double kMaxTableCents = 0.02;
+
+static int failures = 0;
+
+//-----------------------------------------------------------------------------
+static void report (const char* name, double maxError, double bound, const char* unit)
+{
+	bool ok = maxError <= bound;
+	printf ("%-34s max error %.3g %s (bound %.3g) %s\n", name, maxError, unit, bound, ok ? "ok" : "FAILED");
+	if (!ok)
+		failures++;
+}
+
+//-----------------------------------------------------------------------------
+static double cents (double value, double reference)
+{
+	return std::fabs (1200. * std::log2 (value / reference));
+}
+
+//-----------------------------------------------------------------------------
+static double decibels (double value, double reference)
+{
+	return std::fabs (20. * std::log10 (value / reference));
+}
+
+//-----------------------------------------------------------------------------
+static void testExp2 ()
+{
+	// the whole range in octaves, relative error as pitch
+	double maxCents = 0.;
+	for (double x = -1000.; x <= 1000.; x += 0.0137)
+		maxCents = std::max (maxCents, cents (FastMath::exp2 (x), std::exp2 (x)));
+	report ("exp2 [-1000, 1000]", maxCents, kMaxPitchCents, "cent");
+}
+
+//-----------------------------------------------------------------------------
+static void testLog2 ()
+{
+	double maxError = 0.;
+	for (double e = -1000.; e <= 1000.; e += 0.0137)
+	{
+		double x = std::exp2 (e);
+		maxError = std::max (maxError, std::fabs (FastMath::log2 (x) - std::log2 (x)));
+	}
+	report ("log2 [2^-1000, 2^1000]", maxError, kMaxLog2Error, "");
+}
+
+//-----------------------------------------------------------------------------
+static void testPow ()
+{
+	// tuning and detune: 2^(semitones / 12) over +-10 octaves
+	double maxCents = 0.;
+	for (double semitones = -120.; semitones <= 120.; semitones += 0.001)
+		maxCents = std::max (maxCents, cents (FastMath::pow (2., semitones / 12.), std::pow (2., semitones / 12.)));
+	report ("pow (2, semitones / 12)", maxCents, kMaxPitchCents, "cent");
+
+	// gains: 10^(dB / 20) from silence to +24 dB
+	double maxDb = 0.;
+	for (double db = -144.; db <= 24.; db += 0.001)
+		maxDb = std::max (maxDb, decibels (FastMath::pow (10., db / 20.), std::pow (10., db / 20.)));
+	report ("pow (10, dB / 20)", maxDb, kMaxGainDb, "dB");
+
+	// normalizedLevel2Gain style curves: x^y for x in (0, 1]
+	maxDb = 0.;
+	for (double x = 1e-6; x <= 1.; x += 1e-5)
+		maxDb = std::max (maxDb, decibels (FastMath::pow (x, 2.5), std::pow (x, 2.5)));
+	report ("pow (x, 2.5), x in (0, 1]", maxDb, kMaxGainDb, "dB");
+
+	if (FastMath::pow (0., 2.) != 0. || FastMath::pow (-1., 2.) != 0.)
+	{
+		printf ("pow of x <= 0 is not 0 FAILED\n");
+		failures++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+static void testSin ()
+{
+	double maxError = 0.;
+	for (double x = -100.; x <= 100.; x += 0.00071)
+		maxError = std::max (maxError, std::fabs (FastMath::sin (x) - std::sin (x)));
+	report ("sin [-100, 100]", maxError, kMaxSinError, "");
+}
+
+//-----------------------------------------------------------------------------
+/** the shape of VoiceStatics::freqLogScale (10 Hz - 20 kHz, 447.213 Hz at 0.5) */
+struct FrequencyScale
+{
+	FrequencyScale ()
+	{
+		double t = (447.213 - 10.) / (20000. - 10.);
+		b = std::log (1. / t - 1.) * 2.;
+		a = (20000. - 10.) / (std::exp (b) - 1.);
+		c = 10. - a;
+	}
+	double scale (double in) const { return a * std::exp (b * in) + c; }
+	double a, b, c;
+};
+
+//-----------------------------------------------------------------------------
+static void testLogScaleTable ()
+{
+	FrequencyScale frequencyScale;
+	static LogScaleTable<double> table;
+	table.update (frequencyScale);
+	double maxCents = 0.;
+	for (double x = 0.; x <= 1.; x += 1e-6)
+		maxCents = std::max (maxCents, cents (table.scale (x), frequencyScale.scale (x)));
+	report ("LogScaleTable 10 Hz - 20 kHz", maxCents, kMaxTableCents, "cent");
+}
+
+//-----------------------------------------------------------------------------
+/** what the voices evaluate per block at full polyphony, with both implementations */
+static void benchmark ()
+{
+	enum
+	{
+		kNumVoices = 128,
+		kNumBlocks = 20000
+	};
+	volatile double sink = 0.;
+	auto run = [&] (auto exp2, auto pow) {
+		auto start = std::chrono::steady_clock::now ();
+		double sum = 0.;
+		for (int32 block = 0; block < kNumBlocks; block++)
+		{
+			for (int32 voice = 0; voice < kNumVoices; voice++)
+			{
+				double x = (voice + block * 1e-4) / kNumVoices;
+				sum += exp2 (x * 4. - 2.);			// tuning
+				sum += exp2 (x * 0.1);				// detune
+				sum += pow (10., x * -2.);			// normalizedLevel2Gain
+				sum += pow (x + 0.01, 3.);			// envelope curve
+			}
+		}
+		sink = sink + sum;
+		return std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	};
+	double stdSeconds = run ([] (double x) { return std::exp2 (x); }, [] (double x, double y) { return std::pow (x, y); });
+	double fastSeconds = run ([] (double x) { return FastMath::exp2 (x); }, [] (double x, double y) { return FastMath::pow (x, y); });
+	printf ("%d voices x %d blocks: std %.2f ms, FastMath %.2f ms (%.1fx)\n", kNumVoices, kNumBlocks,
+	        stdSeconds * 1e3, fastSeconds * 1e3, stdSeconds / fastSeconds);
+}
+
+//-----------------------------------------------------------------------------
+int main ()
+{
+	testExp2 ();
+	testLog2 ();
+	testPow ();
+	testSin ();
+	testLogScaleTable ();
+	benchmark ();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/test/releasetail_benchmark.cpp
+// Description : Cost of a long release tail of 64 voices, with and without FTZ/DAZ and on RenderPool workers
+//
+//-----------------------------------------------------------------------------
+
+#include "../source/filter.h"
+#include "../source/denormals.h"
+#include "../source/renderpool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst::NoteExpressionSynth;
+
+//-----------------------------------------------------------------------------
+enum
+{
+	kNumVoices = 64,
+	kBlockSize = 64,
+	kNumBlocks = 2000,
+	kNumThreads = 2		// RenderPool workers besides the calling thread
+};
+
+enum Mode
+{
+	kHostMode,
+	kFlushDenormals,	// on the calling thread, like Processor::process
+	kRenderPool,		// the same, the voices are rendered by a RenderPool
+	kNumModes
+};
+
+// with ScopedFlushDenormals the tail may cost at most this much more than the sustain
+static const double kMaxTailRatio = 2.;
+
+//-----------------------------------------------------------------------------
+/** The recursive state of a releasing voice: an oscillator, an exponentially decaying volume
+	(not flushed, like any state outside the filters) and the three filters of a voice. */
+struct ReleasingVoice
+{
+	ReleasingVoice () : filter (Filter::kLowpass), filterOne (Filter::kLowpass), filterTwo (Filter::kBandpass) {}
+
+	void start (int32 index, double startVolume)
+	{
+		Filter* filters[] = {&filter, &filterOne, &filterTwo};
+		for (Filter* f : filters)
+		{
+			f->setSampleRate (44100.);
+			f->setFreqAndQ (200. + index * 100., 0.7);
+			f->reset ();
+		}
+		double omega = 6.28318530717958647692 * (100. + index * 37.) / 44100.;
+		cosine = std::cos (omega);
+		sine = std::sin (omega);
+		oscillator[0] = 1.;
+		oscillator[1] = 0.;
+		volume = startVolume;
+	}
+
+	double process ()
+	{
+		double x = oscillator[0] * cosine - oscillator[1] * sine;
+		oscillator[1] = oscillator[0] * sine + oscillator[1] * cosine;
+		oscillator[0] = x;
+		volume *= 0.99999;
+		double sample = x * volume;
+		return filterTwo.process (filterOne.process (filter.process (sample)));
+	}
+
+	Filter filter;
+	Filter filterOne;
+	Filter filterTwo;
+	double oscillator[2];
+	double cosine;
+	double sine;
+	double volume;
+};
+
+static ReleasingVoice voices[kNumVoices];
+static volatile double sink;
+
+//-----------------------------------------------------------------------------
+/** one task per voice, every voice sums into its own slot. Also counts the tasks which ran
+	in a thread without FTZ/DAZ, independent of how fast the machine is. */
+struct VoiceTasks : IRenderTasks
+{
+	void runTask (int32 task) override
+	{
+		volatile double denormal = 1e-310;
+		if (denormal * 0.5 != 0.)
+			unflushedTasks++;
+		for (int32 s = 0; s < kBlockSize; s++)
+			sums[task] += voices[task].process ();
+	}
+
+	double sums[kNumVoices] {};
+	std::atomic<int32> unflushedTasks {0};
+};
+
+static int32 unflushedTasks;
+static int32 workerTasks;
+
+//-----------------------------------------------------------------------------
+/** nanoseconds per voice and sample for kNumBlocks blocks starting at startVolume */
+static double render (double startVolume, Mode mode, RenderPool& pool)
+{
+	for (int32 i = 0; i < kNumVoices; i++)
+		voices[i].start (i, startVolume);
+
+	VoiceTasks tasks;
+	double seconds = 0.;
+	double sum = 0.;
+	for (int32 block = 0; block < kNumBlocks; block++)
+	{
+		// like Processor::process: the mode is set per block and restored for the host
+		auto start = std::chrono::steady_clock::now ();
+		if (mode == kRenderPool)
+		{
+			ScopedFlushDenormals flush;
+			pool.run (&tasks, kNumVoices);
+			for (int32 w = 1; w < pool.getNumWorkers (); w++)
+				workerTasks += pool.getWorkerTasks (w);
+		}
+		else if (mode == kFlushDenormals)
+		{
+			ScopedFlushDenormals flush;
+			for (int32 i = 0; i < kNumVoices; i++)
+				for (int32 s = 0; s < kBlockSize; s++)
+					sum += voices[i].process ();
+		}
+		else
+		{
+			for (int32 i = 0; i < kNumVoices; i++)
+				for (int32 s = 0; s < kBlockSize; s++)
+					sum += voices[i].process ();
+		}
+		seconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	}
+	for (int32 i = 0; i < kNumVoices; i++)
+		sum += tasks.sums[i];
+	sink = sum;
+	unflushedTasks += tasks.unflushedTasks;
+	return seconds * 1e9 / ((double)kNumVoices * kBlockSize * kNumBlocks);
+}
+
+//-----------------------------------------------------------------------------
+int main ()
+{
+	// the tail starts at a volume which stays denormal for the whole run
+	const double kSustainVolume = 0.5;
+	const double kTailVolume = 1e-310;
+
+	// the workers set their own FP mode, the scope of the calling thread does not reach them
+	RenderPool pool;
+	pool.start (kNumThreads, (double)kBlockSize / 44100.);
+
+	static const char* names[kNumModes] = {"host FP mode", "ScopedFlushDenormals", "RenderPool"};
+	int failures = 0;
+	for (int32 mode = 0; mode < kNumModes; mode++)
+	{
+		unflushedTasks = 0;
+		workerTasks = 0;
+		double sustain = render (kSustainVolume, (Mode)mode, pool);
+		double tail = render (kTailVolume, (Mode)mode, pool);
+		double ratio = tail / sustain;
+		bool ok = mode == kHostMode || (ratio <= kMaxTailRatio && unflushedTasks == 0);
+		printf ("%-22s sustain %.2f ns, tail %.2f ns per voice sample (%.1fx)%s\n", names[mode],
+		        sustain, tail, ratio, mode == kHostMode ? "" : (ok ? " ok" : " FAILED"));
+		if (mode == kRenderPool)
+			printf ("%-22s %d tasks on workers, %d without FTZ/DAZ\n", "", workerTasks, unflushedTasks);
+		if (!ok)
+			failures++;
+	}
+	pool.stop ();
+	return failures == 0 ? 0 : 1;
+}
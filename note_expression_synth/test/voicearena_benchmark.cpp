@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+// Project     : VST SDK
+//
+// Category    : Examples
+// Filename    : public.sdk/samples/vst/note_expression_synth/test/voicearena_benchmark.cpp
+// Description : Cache misses of the per block voice pass, scattered voices against the arena
+//
+//-----------------------------------------------------------------------------
+
+#include "../source/filter.h"
+#include "../source/voicearena.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst::NoteExpressionSynth;
+
+//-----------------------------------------------------------------------------
+enum
+{
+	kBlockSize = 32,
+	kNumBlocks = 300,
+	kEvictSize = 16 * 1024 * 1024	// written between blocks, like the other plugins of a host
+};
+
+//-----------------------------------------------------------------------------
+/** The cold data of a voice: the GPU upload buffer and the two wavetables. */
+struct ColdData
+{
+	float upload[8192];
+	float dataA[1024];
+	float dataB[1024];
+};
+
+//-----------------------------------------------------------------------------
+/** The layout before the arena: hot fields before, between and after the cold arrays and the
+	filters on the heap. */
+struct ScatteredVoice
+{
+	ScatteredVoice ()
+	: filter (new Filter (Filter::kLowpass))
+	, filterOne (new Filter (Filter::kLowpass))
+	, filterTwo (new Filter (Filter::kBandpass))
+	{
+	}
+	~ScatteredVoice ()
+	{
+		delete filter;
+		delete filterOne;
+		delete filterTwo;
+	}
+
+	int32 noteId;
+	double phase;
+	Filter* filter;
+	ColdData cold;
+	double increment;
+	Filter* filterOne;
+	double volume;
+	double volumeRamp;
+	Filter* filterTwo;
+};
+
+//-----------------------------------------------------------------------------
+/** The arena layout: the hot block on its own cache lines, the filters inline, the cold data
+	behind all voices. */
+struct ArenaVoice
+{
+	typedef ColdData Buffers;
+
+	ArenaVoice () : filter (Filter::kLowpass), filterOne (Filter::kLowpass), filterTwo (Filter::kBandpass) {}
+	void setBuffers (Buffers* _buffers) { buffers = _buffers; }
+
+	int32 noteId;
+	double phase;
+	double increment;
+	double volume;
+	double volumeRamp;
+	Filter filter;
+	Filter filterOne;
+	Filter filterTwo;
+	Buffers* buffers;
+};
+
+//-----------------------------------------------------------------------------
+template<class Voice>
+static Filter& getFilter (Voice& voice, int32 index);
+template<>
+Filter& getFilter (ScatteredVoice& voice, int32 index)
+{
+	return index == 0 ? *voice.filter : index == 1 ? *voice.filterOne : *voice.filterTwo;
+}
+template<>
+Filter& getFilter (ArenaVoice& voice, int32 index)
+{
+	return index == 0 ? voice.filter : index == 1 ? voice.filterOne : voice.filterTwo;
+}
+
+//-----------------------------------------------------------------------------
+template<class Voice>
+static void startVoice (Voice& voice, int32 index)
+{
+	voice.noteId = index;
+	voice.phase = 0.;
+	voice.increment = 6.28318530717958647692 * (100. + index) / 44100.;
+	voice.volume = 0.5;
+	voice.volumeRamp = 1e-6;
+	for (int32 f = 0; f < 3; f++)
+	{
+		getFilter (voice, f).setSampleRate (44100.);
+		getFilter (voice, f).setFreqAndQ (1000., 0.7);
+	}
+}
+
+//-----------------------------------------------------------------------------
+/** what the voice processor does per block: find the playing voices, then render them */
+template<class Voice>
+static double renderBlock (Voice** voices, int32 numVoices)
+{
+	double sum = 0.;
+	for (int32 i = 0; i < numVoices; i++)
+	{
+		Voice& voice = *voices[i];
+		if (voice.noteId == -1)
+			continue;
+		for (int32 s = 0; s < kBlockSize; s++)
+		{
+			voice.phase += voice.increment;
+			voice.volume -= voice.volumeRamp;
+			double sample = (voice.phase - (int64)voice.phase) * voice.volume;
+			for (int32 f = 0; f < 3; f++)
+				sample = getFilter (voice, f).process (sample);
+			sum += sample;
+		}
+	}
+	return sum;
+}
+
+static std::vector<char> evict (kEvictSize);
+static volatile double sink;
+
+//-----------------------------------------------------------------------------
+/** nanoseconds per voice and block, with a cold cache at every block */
+template<class Voice>
+static double measure (Voice** voices, int32 numVoices)
+{
+	for (int32 i = 0; i < numVoices; i++)
+		startVoice (*voices[i], i);
+	double seconds = 0.;
+	double sum = 0.;
+	for (int32 block = 0; block < kNumBlocks; block++)
+	{
+		memset (evict.data (), block, evict.size ());
+		auto start = std::chrono::steady_clock::now ();
+		sum += renderBlock (voices, numVoices);
+		seconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	}
+	sink = sum;
+	return seconds * 1e9 / ((double)numVoices * kNumBlocks);
+}
+
+//-----------------------------------------------------------------------------
+int main ()
+{
+	const int32 numVoicesList[] = {16, 64, 256};
+	for (int32 numVoices : numVoicesList)
+	{
+		std::vector<ScatteredVoice*> scattered;
+		for (int32 i = 0; i < numVoices; i++)
+			scattered.push_back (new ScatteredVoice);
+
+		VoiceArena<ArenaVoice> arena (numVoices);
+		std::vector<ArenaVoice*> packed;
+		for (int32 i = 0; i < numVoices; i++)
+			packed.push_back (&arena[i]);
+
+		double scatteredNanos = measure (scattered.data (), numVoices);
+		double packedNanos = measure (packed.data (), numVoices);
+		printf ("%3d voices: scattered %.0f ns, arena %.0f ns per voice and block (%.2fx)\n", numVoices,
+		        scatteredNanos, packedNanos, scatteredNanos / packedNanos);
+
+		for (ScatteredVoice* voice : scattered)
+			delete voice;
+	}
+	return 0;
+}